@@ -17,6 +17,8 @@ struct WamrExtModule;
 typedef struct WamrExtModule* wamr_ext_module_t;
 struct WamrExtInstance;
 typedef struct WamrExtInstance* wamr_ext_instance_t;
+struct WamrExtFunc;
+typedef struct WamrExtFunc* wamr_ext_func_t;
 
 #ifdef __cplusplus
 extern "C" {
@@ -30,6 +32,7 @@ enum WamrExtInstanceOpt {
     // Set arguments that will be passed to main(), value type: char**(ends with NULL)
     WAMR_EXT_INST_OPT_ARG = 4,
     // Set callback when WAsm app raises exception during running(e.g. out of memory access), value type: WamrExtInstanceExceptionCB*
+    // The callback is called in a wamr-ext thread, and never called after wamr_ext_instance_destroy() returns.
     WAMR_EXT_INST_OPT_EXCEPTION_CALLBACK = 5,
     // Add a host command to whitelist to allow WAsm app to execute it.
     // Value type: WamrExtKeyValueSS*, where key is the command name(NOT command path) used by WAsm app, value is the mapped host command name or path.
@@ -37,6 +40,41 @@ enum WamrExtInstanceOpt {
     WAMR_EXT_INST_OPT_ADD_HOST_COMMAND = 6,
     // Set maximum memory size(bytes), value type: uint32_t*
     WAMR_EXT_INST_OPT_MAX_MEMORY = 7,
+    // Set CPU time budget(microseconds) of the main thread and all app threads, 0 means unlimited, value type: uint64_t*
+    // The instance raises an exception once the budget is exceeded, it's checked periodically so it may be overrun slightly.
+    WAMR_EXT_INST_OPT_MAX_CPU_TIME = 8,
+    // Set timeout(milliseconds) of each function call to the instance, 0 means unlimited, value type: uint32_t*
+    // The instance is terminated and raises an exception when the timeout expires.
+    WAMR_EXT_INST_OPT_EXEC_TIMEOUT = 9,
+    // Set size(bytes) of the ring buffer allocated in app heap for wamr_ext_instance_acquire_buffer(), 0 means disabled, value type: uint32_t*
+    WAMR_EXT_INST_OPT_IO_BUFFER_SIZE = 10,
+    // Allow WAsm app to open the channel shared with other instances in the same process, value type: WamrExtChannelOpt*
+    WAMR_EXT_INST_OPT_ADD_CHANNEL = 11,
+    // Set file path to dump PGO profile data when the instance is destroyed, value type: const char*
+    // The module must be compiled by wamr-ext-aot.py --instrument and wamr-ext must be built with WAMR_EXT_BUILD_STATIC_PGO.
+    WAMR_EXT_INST_OPT_PGO_PROFILE_FILE = 12,
+};
+
+enum WamrExtGlobalOpt {
+    // Set directory of AOT files compiled from wasm bytecode modules, value type: const char*
+    // When a wasm bytecode module is loaded, <SHA-256 of content>-<AOT target>-<wamr-ext version>.aot in the dir is loaded instead
+    // if it exists. Use wamr-ext-aot.py --cache-dir to compile files into the dir.
+    WAMR_EXT_GLOBAL_OPT_AOT_CACHE_DIR = 1,
+    // Enable(non-zero) or disable(0, default) collecting stats of ext syscalls made by WAsm apps, value type: uint32_t*
+    // Stats are got by wamr_ext_instance_get_syscall_stats(), or by WAsm apps via sysctl "stats.syscall".
+    WAMR_EXT_GLOBAL_OPT_SYSCALL_STATS = 4,
+    // Enable(non-zero) or disable(0, default) writing symbols of AOT functions to /tmp/perf-<pid>.map for Linux perf, value type: uint32_t*
+    // Functions are named wasm!<module name>!<function name>, names come from the name section if the AOT file keeps it
+    // (e.g. wamrc --enable-dump-call-stack), otherwise from exports.
+    WAMR_EXT_GLOBAL_OPT_PERF_MAP = 5,
+};
+
+enum WamrExtModuleLoadFlag {
+    // Execute the code of AOT files compiled in XIP mode(wamr-ext-aot.py --xip) from a read-only shared mapping of the file,
+    // so that code pages are shared across processes in the page cache instead of being copied into each process.
+    // References of the code are relocated into small writable tables allocated by the loader, the code is never writable.
+    // It's ignored for wasm bytecode files and AOT files not compiled in XIP mode.
+    WAMR_EXT_MODULE_LOAD_FLAG_XIP = 1,
 };
 
 struct WamrExtKeyValueSS {
@@ -44,6 +82,14 @@ struct WamrExtKeyValueSS {
     const char* v;
 };
 
+#define WAMR_EXT_DEFAULT_CHANNEL_CAPACITY (1024 * 1024)
+
+struct WamrExtChannelOpt {
+    const char* name;
+    // Size(bytes) of the ring buffer, 0 means WAMR_EXT_DEFAULT_CHANNEL_CAPACITY. It takes effect only for the instance creating the channel.
+    uint32_t capacity;
+};
+
 struct WamrExtExceptionInfo;
 typedef struct WamrExtExceptionInfo wamr_ext_exception_info_t;
 
@@ -59,9 +105,80 @@ struct WamrExtInstanceExceptionCB {
     void* user_data;
 };
 
+// Buffer inside the linear memory of an instance, host_ptr is only valid before the linear memory grows
+struct WamrExtBuffer {
+    void* host_ptr;
+    uint32_t app_offset;
+    uint32_t size;
+};
+
+enum WamrExtValueKind {
+    WAMR_EXT_VALUE_I32 = 0,
+    WAMR_EXT_VALUE_I64 = 1,
+    WAMR_EXT_VALUE_F32 = 2,
+    WAMR_EXT_VALUE_F64 = 3,
+};
+
+// Argument or result of WAsm functions
+struct WamrExtValue {
+    enum WamrExtValueKind kind;
+    union {
+        int32_t i32;
+        int64_t i64;
+        float f32;
+        double f64;
+    } of;
+};
+
+// Stats of an ext syscall made by an instance, the layout is shared with sysctl "stats.syscall" of WAsm apps
+struct WamrExtSyscallStats {
+    uint32_t syscall_id;
+    uint32_t __reserved;
+    uint64_t call_count;
+    // Calls returning non-zero error codes
+    uint64_t error_count;
+    uint64_t total_ns;
+    // Latency percentiles from a log-linear histogram, which may be overestimated by up to 25%
+    uint64_t p50_ns;
+    uint64_t p90_ns;
+    uint64_t p99_ns;
+    uint64_t max_ns;
+};
+
+struct WamrExtInstanceStats {
+    // Current and maximum size(bytes) of the linear memory, the current size is committed
+    uint64_t memory_size;
+    uint64_t memory_max_size;
+    // Bytes of the linear memory resident in physical memory, 0 if unsupported
+    uint64_t memory_resident_size;
+    // App heap managed by the runtime inside the linear memory, all 0 if the app manages its own heap(e.g. wasi-libc malloc)
+    uint64_t app_heap_size;
+    uint64_t app_heap_free_size;
+    // Maximum bytes that have been allocated from the app heap
+    uint64_t app_heap_highmark_size;
+    // Main thread and running app threads
+    uint32_t thread_count;
+    uint32_t fd_count;
+    uint32_t child_process_count;
+    uint32_t __reserved;
+    uint64_t cpu_time_us;
+};
+
+struct WamrExtCallCompletionCB {
+    // Called in a worker thread when the function returns. err is 0 on success, otherwise the error string can be got by
+    // wamr_ext_strerror(err) inside the callback. results are valid only during the callback.
+    void(*func)(int32_t err, const struct WamrExtValue* results, uint32_t result_count, void* user_data);
+    void* user_data;
+};
+
 WAMR_EXT_API void wamr_ext_version(const char** ver_str, uint32_t* ver_code);
 WAMR_EXT_API int32_t wamr_ext_init();
+WAMR_EXT_API int32_t wamr_ext_set_global_opt(enum WamrExtGlobalOpt opt, const void* value);
+// AOT files must be compiled by wamr-ext-aot.py with --hw-bound-check if and only if wamr-ext is built with
+// WAMR_EXT_HW_BOUND_CHECK, files of the other bound check mode are refused.
 WAMR_EXT_API int32_t wamr_ext_module_load_by_file(wamr_ext_module_t* module, const char* module_name, const char* file_path);
+// flags: bitwise OR of WamrExtModuleLoadFlag
+WAMR_EXT_API int32_t wamr_ext_module_load_by_file_ex(wamr_ext_module_t* module, const char* module_name, const char* file_path, uint32_t flags);
 WAMR_EXT_API int32_t wamr_ext_module_load_by_buffer(wamr_ext_module_t* module, const char* module_name, const uint8_t* buf, uint32_t len);
 WAMR_EXT_API int32_t wamr_ext_module_set_inst_default_opt(wamr_ext_module_t* module, enum WamrExtInstanceOpt opt, const void* value);
 WAMR_EXT_API int32_t wamr_ext_instance_create(wamr_ext_module_t* module, wamr_ext_instance_t* inst);
@@ -69,6 +186,43 @@ WAMR_EXT_API int32_t wamr_ext_instance_set_opt(wamr_ext_instance_t* inst, enum W
 WAMR_EXT_API int32_t wamr_ext_instance_start(wamr_ext_instance_t* inst);
 WAMR_EXT_API int32_t wamr_ext_instance_exec_main_func(wamr_ext_instance_t* inst, int32_t* ret_value);
 WAMR_EXT_API int32_t wamr_ext_instance_destroy(wamr_ext_instance_t* inst);
+// Terminate the running main thread and all app threads of the instance, blocking host calls made by them will be interrupted.
+// The instance cannot execute any function after terminated and it should be destroyed.
+WAMR_EXT_API int32_t wamr_ext_instance_terminate(wamr_ext_instance_t* inst);
+// Look up the exported function func_name of a started instance, the handle is shared by all instances of the same module.
+WAMR_EXT_API int32_t wamr_ext_instance_lookup_func(wamr_ext_instance_t* inst, const char* func_name, wamr_ext_func_t* func);
+// Call the function got by wamr_ext_instance_lookup_func(), kinds of argv must match the function parameters,
+// result_count must be at least the number of function results.
+WAMR_EXT_API int32_t wamr_ext_instance_call_func(wamr_ext_instance_t* inst, wamr_ext_func_t* func, const struct WamrExtValue* argv,
+                                                 uint32_t argc, struct WamrExtValue* results, uint32_t result_count);
+// Call the exported function func_name with args in a worker thread and return immediately, completion_cb is called when done.
+// Calls to the same instance are queued and executed one by one in at most one worker thread at a time.
+// If the instance has been destroyed when the call begins, the callback gets an error.
+WAMR_EXT_API int32_t wamr_ext_instance_call_async(wamr_ext_instance_t* inst, const char* func_name, const struct WamrExtValue* args,
+                                                  uint32_t argc, const struct WamrExtCallCompletionCB* completion_cb);
+// Acquire a buffer in the linear memory of a started instance, the host writes data via host_ptr and passes app_offset to
+// the WAsm function, then releases it after the call. It is allocated from the IO ring buffer or from app heap if the ring is full.
+WAMR_EXT_API int32_t wamr_ext_instance_acquire_buffer(wamr_ext_instance_t* inst, uint32_t size, struct WamrExtBuffer* buf);
+WAMR_EXT_API int32_t wamr_ext_instance_release_buffer(wamr_ext_instance_t* inst, const struct WamrExtBuffer* buf);
+// Get host address of the app buffer [app_offset, app_offset + size), e.g. the reply returned by a WAsm function, without copy
+WAMR_EXT_API int32_t wamr_ext_instance_map_app_buffer(wamr_ext_instance_t* inst, uint32_t app_offset, uint32_t size, void** host_ptr);
+// Dump PGO profile data(LLVM raw profile) collected by a started instance of the module compiled by wamr-ext-aot.py --instrument,
+// then pass it to wamr-ext-aot.py --use-profile. It requires wamr-ext built with WAMR_EXT_BUILD_STATIC_PGO.
+WAMR_EXT_API int32_t wamr_ext_instance_dump_pgo_profile(wamr_ext_instance_t* inst, const char* file_path);
+// Get CPU time(microseconds) consumed by the main thread and all app threads of the instance
+WAMR_EXT_API int32_t wamr_ext_instance_get_cpu_time(wamr_ext_instance_t* inst, uint64_t* cpu_time_us);
+// Get memory usage and resource counts of a started instance, it doesn't stop the instance so it's cheap to poll
+WAMR_EXT_API int32_t wamr_ext_instance_get_stats(wamr_ext_instance_t* inst, struct WamrExtInstanceStats* stats);
+// Get stats of ext syscalls made by the instance since WAMR_EXT_GLOBAL_OPT_SYSCALL_STATS is enabled. count is the capacity
+// of stats on input and the number of called syscalls on output, ERANGE is returned if stats is too small.
+WAMR_EXT_API int32_t wamr_ext_instance_get_syscall_stats(wamr_ext_instance_t* inst, struct WamrExtSyscallStats* stats, uint32_t* count);
+// Start sampling wasm call stacks of all started instances sample_hz times per second, samples collected before are cleared.
+// Stacks of threads blocked in host calls are sampled too. AOT modules must be compiled with wamrc --enable-dump-call-stack.
+WAMR_EXT_API int32_t wamr_ext_profiler_start(uint32_t sample_hz);
+WAMR_EXT_API int32_t wamr_ext_profiler_stop();
+// Write samples to file_path in collapsed stack format("<module>;<root func>;...;<leaf func> <count>" per line),
+// which can be rendered by flamegraph.pl or speedscope. It can be called while the profiler is running.
+WAMR_EXT_API int32_t wamr_ext_profiler_dump(const char* file_path);
 
 WAMR_EXT_API const char* wamr_ext_strerror(int32_t err);
 WAMR_EXT_API int32_t wamr_ext_exception_get_info(wamr_ext_exception_info_t* exception, enum WamrExtExceptionInfoEnum info, void* value);
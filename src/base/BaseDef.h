@@ -3,6 +3,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <cstdint>
+#include <cinttypes>
 #include <climits>
 #include <cerrno>
 #include <cassert>
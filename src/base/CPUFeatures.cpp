@@ -0,0 +1,105 @@
+#include "CPUFeatures.h"
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <cpuid.h>
+#elif defined(__aarch64__) && defined(__linux__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+namespace WAMR_EXT_NS {
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    // Feature sets of the x86-64 psABI microarchitecture levels, same as -march=x86-64-v2/v3/v4 of LLVM and GCC.
+    // CPUID.1:ECX
+#define X86_SSE3        (1u << 0)
+#define X86_SSSE3       (1u << 9)
+#define X86_FMA         (1u << 12)
+#define X86_CMPXCHG16B  (1u << 13)
+#define X86_SSE4_1      (1u << 19)
+#define X86_SSE4_2      (1u << 20)
+#define X86_MOVBE       (1u << 22)
+#define X86_POPCNT      (1u << 23)
+#define X86_OSXSAVE     (1u << 27)
+#define X86_AVX         (1u << 28)
+#define X86_F16C        (1u << 29)
+    // CPUID.80000001H:ECX
+#define X86_LAHF_SAHF   (1u << 0)
+#define X86_LZCNT       (1u << 5)
+    // CPUID.(EAX=7,ECX=0):EBX
+#define X86_BMI1        (1u << 3)
+#define X86_AVX2        (1u << 5)
+#define X86_BMI2        (1u << 8)
+#define X86_AVX512F     (1u << 16)
+#define X86_AVX512DQ    (1u << 17)
+#define X86_AVX512CD    (1u << 28)
+#define X86_AVX512BW    (1u << 30)
+#define X86_AVX512VL    (1u << 31)
+    // XCR0, states of SSE and AVX registers, then opmask and upper ZMM registers, which must be enabled by the OS
+#define X86_XCR0_AVX    0x6u
+#define X86_XCR0_AVX512 0xe0u
+
+    // Return the highest level supported by the host CPU and OS, 1 is the baseline
+    static int GetX86_64Level() {
+        uint32_t eax, ebx, ecx, edx, ecx1, ecxExt = 0, ebx7 = 0;
+        if (!__get_cpuid(1, &eax, &ebx, &ecx1, &edx))
+            return 1;
+        if (__get_cpuid(0x80000001, &eax, &ebx, &ecx, &edx))
+            ecxExt = ecx;
+        if (__get_cpuid_max(0, nullptr) >= 7)
+            __cpuid_count(7, 0, eax, ebx7, ecx, edx);
+        const uint32_t v2Ecx1 = X86_SSE3 | X86_SSSE3 | X86_CMPXCHG16B | X86_SSE4_1 | X86_SSE4_2 | X86_POPCNT;
+        if ((ecx1 & v2Ecx1) != v2Ecx1 || !(ecxExt & X86_LAHF_SAHF))
+            return 1;
+        const uint32_t v3Ecx1 = X86_FMA | X86_MOVBE | X86_OSXSAVE | X86_AVX | X86_F16C;
+        const uint32_t v3Ebx7 = X86_BMI1 | X86_AVX2 | X86_BMI2;
+        if ((ecx1 & v3Ecx1) != v3Ecx1 || !(ecxExt & X86_LZCNT) || (ebx7 & v3Ebx7) != v3Ebx7)
+            return 2;
+        // XGETBV is available since OSXSAVE is set
+        uint32_t xcr0, xcr0High;
+        __asm__ volatile("xgetbv" : "=a"(xcr0), "=d"(xcr0High) : "c"(0));
+        if ((xcr0 & X86_XCR0_AVX) != X86_XCR0_AVX)
+            return 2;
+        const uint32_t v4Ebx7 = X86_AVX512F | X86_AVX512DQ | X86_AVX512CD | X86_AVX512BW | X86_AVX512VL;
+        if ((ebx7 & v4Ebx7) != v4Ebx7 || (xcr0 & X86_XCR0_AVX512) != X86_XCR0_AVX512)
+            return 3;
+        return 4;
+    }
+#endif
+
+    bool CPUFeatures::IsAOTProfileSupported(const char* profile) {
+        if (strcmp(profile, "baseline") == 0)
+            return true;
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+        // Profiles of wamr-ext-aot.py AOT_PROFILES for x86_64-gnu
+        static const int hostLevel = GetX86_64Level();
+        if (strcmp(profile, "x86-64-v2") == 0)
+            return hostLevel >= 2;
+        if (strcmp(profile, "x86-64-v3") == 0)
+            return hostLevel >= 3;
+        if (strcmp(profile, "x86-64-v4") == 0)
+            return hostLevel >= 4;
+#elif defined(__aarch64__) && defined(__linux__)
+        // Profiles of wamr-ext-aot.py AOT_PROFILES for aarch64-gnu
+        if (strcmp(profile, "armv8.2-dotprod") == 0) {
+            unsigned long hwcap = getauxval(AT_HWCAP);
+            return (hwcap & HWCAP_ASIMD) && (hwcap & HWCAP_ASIMDDP);
+        }
+#endif
+        return false;
+    }
+
+    bool CPUFeatures::IsBuildTargetSupported(const char*& outRequiredProfile) {
+        outRequiredProfile = m_gBuildTargetProfile;
+        return IsAOTProfileSupported(outRequiredProfile);
+    }
+
+#if defined(__GNUC__) || defined(__clang__)
+    // Run before static initializers of other files, which may already use instructions of the build target
+    __attribute__((constructor(101))) static void CheckBuildTargetAtLoad() {
+        const char* requiredProfile = nullptr;
+        if (!CPUFeatures::IsBuildTargetSupported(requiredProfile)) {
+            fprintf(stderr, "Host CPU doesn't support %s which wamr-ext is built for\n", requiredProfile);
+            abort();
+        }
+    }
+#endif
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include "BaseDef.h"
+
+namespace WAMR_EXT_NS {
+    class CPUFeatures {
+    public:
+        // Check whether the host CPU can run AOT code compiled with the profile of wamr-ext-aot.py
+        static bool IsAOTProfileSupported(const char* profile);
+        // Check whether the host CPU supports the instruction set that wamr-ext is compiled for(e.g. -march=x86-64-v3),
+        // outRequiredProfile is set to the missing profile if not. It's also checked at load time before static initializers.
+        static bool IsBuildTargetSupported(const char*& outRequiredProfile);
+    private:
+        // Defined in CPUFeaturesBuildTarget.cpp compiled with the flags of wamr-ext, while this file is compiled for the baseline
+        static const char* const m_gBuildTargetProfile;
+    };
+}
@@ -0,0 +1,14 @@
+#include "CPUFeatures.h"
+
+namespace WAMR_EXT_NS {
+    // Only constant data here, it's read by the CPU check before any code compiled for the build target runs
+#if defined(__AVX512F__) && defined(__AVX512BW__) && defined(__AVX512CD__) && defined(__AVX512DQ__) && defined(__AVX512VL__)
+    const char* const CPUFeatures::m_gBuildTargetProfile = "x86-64-v4";
+#elif defined(__AVX2__) || defined(__BMI2__) || defined(__FMA__) || defined(__F16C__) || defined(__MOVBE__) || defined(__LZCNT__)
+    const char* const CPUFeatures::m_gBuildTargetProfile = "x86-64-v3";
+#elif defined(__SSE4_2__) || defined(__SSE4_1__) || defined(__SSSE3__) || defined(__POPCNT__) || defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_16)
+    const char* const CPUFeatures::m_gBuildTargetProfile = "x86-64-v2";
+#else
+    const char* const CPUFeatures::m_gBuildTargetProfile = "baseline";
+#endif
+}
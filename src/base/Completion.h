@@ -0,0 +1,49 @@
+#pragma once
+#include "BaseDef.h"
+#include "Utility.h"
+
+namespace WAMR_EXT_NS {
+    // One-shot event to wait for work done in other threads, e.g. tasks posted to a loop thread
+    class Completion {
+    public:
+        Completion() = default;
+        Completion(const Completion&) = delete;
+        Completion& operator=(const Completion&) = delete;
+
+        void Signal() {
+            if (m_state.exchange(STATE_SIGNALED, std::memory_order_acq_rel) == STATE_WAITING)
+                Utility::FutexWakeAll(m_state);
+        }
+
+        bool IsSignaled() const { return m_state.load(std::memory_order_acquire) == STATE_SIGNALED; }
+
+        void Wait() {
+            while (!IsSignaled()) {
+                uint32_t expectedState = STATE_INIT;
+                if (m_state.compare_exchange_strong(expectedState, STATE_WAITING, std::memory_order_acq_rel) || expectedState == STATE_WAITING)
+                    Utility::FutexWait(m_state, STATE_WAITING);
+            }
+        }
+
+        // Return false if timed out
+        bool WaitFor(uint64_t timeoutMs) {
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+            while (!IsSignaled()) {
+                auto now = std::chrono::steady_clock::now();
+                if (now >= deadline)
+                    return false;
+                uint32_t expectedState = STATE_INIT;
+                if (m_state.compare_exchange_strong(expectedState, STATE_WAITING, std::memory_order_acq_rel) || expectedState == STATE_WAITING)
+                    Utility::FutexWait(m_state, STATE_WAITING, std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - now).count());
+            }
+            return true;
+        }
+    private:
+        enum : uint32_t {
+            STATE_INIT,
+            STATE_WAITING,
+            STATE_SIGNALED,
+        };
+        std::atomic<uint32_t> m_state{STATE_INIT};
+    };
+}
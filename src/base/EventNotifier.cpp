@@ -0,0 +1,59 @@
+#include "EventNotifier.h"
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+#ifndef _WIN32
+#include <fcntl.h>
+#endif
+
+namespace WAMR_EXT_NS {
+    EventNotifier::EventNotifier() {
+#ifdef __linux__
+        m_readFD = m_writeFD = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+#elif !defined(_WIN32)
+        int pipeFD[2];
+        if (pipe(pipeFD) == 0) {
+            for (int fd : pipeFD) {
+                fcntl(fd, F_SETFD, FD_CLOEXEC);
+                int tempFlags = fcntl(fd, F_GETFL, 0);
+                if (tempFlags != -1)
+                    fcntl(fd, F_SETFL, tempFlags | O_NONBLOCK);
+            }
+            m_readFD = pipeFD[0];
+            m_writeFD = pipeFD[1];
+        }
+#else
+#error "EventNotifier is not implemented for Win32"
+#endif
+        assert(m_readFD != -1);
+    }
+
+    EventNotifier::~EventNotifier() {
+#ifndef _WIN32
+        if (m_readFD != -1)
+            close(m_readFD);
+        if (m_writeFD != -1 && m_writeFD != m_readFD)
+            close(m_writeFD);
+#endif
+    }
+
+    bool EventNotifier::Notify() {
+        if (m_bNotified.exchange(true))
+            return true;
+#ifdef __linux__
+        uint64_t val = 1;
+#elif !defined(_WIN32)
+        uint8_t val = 1;
+#endif
+        while (write(m_writeFD, &val, sizeof(val)) < 0) {
+            if (errno == EINTR)
+                continue;
+            // The eventfd counter or pipe is full, so it is readable already
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
+            m_bNotified.store(false);
+            return false;
+        }
+        return true;
+    }
+}
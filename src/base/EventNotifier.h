@@ -0,0 +1,22 @@
+#pragma once
+#include "BaseDef.h"
+
+namespace WAMR_EXT_NS {
+    // A level-triggered event that can be polled together with other FDs, it stays readable once notified
+    class EventNotifier {
+    public:
+        EventNotifier();
+        ~EventNotifier();
+        EventNotifier(const EventNotifier&) = delete;
+        EventNotifier& operator=(const EventNotifier&) = delete;
+
+        // Returns false if the event cannot be signaled, errno is set then
+        bool Notify();
+        bool IsNotified() const { return m_bNotified.load(std::memory_order_acquire); }
+        int GetPollFD() const { return m_readFD; }
+    private:
+        int m_readFD{-1};
+        int m_writeFD{-1};
+        std::atomic<bool> m_bNotified{false};
+    };
+}
@@ -2,6 +2,17 @@
 #include "Utility.h"
 
 namespace WAMR_EXT_NS {
+    void TimerHandle::Cancel() {
+        if (m_bCancelled.exchange(true, std::memory_order_acq_rel))
+            return;
+        // Release the callback and its captures now instead of at the original deadline
+        pLoop->PostTask([pLoop = pLoop, pWeakHandle = weak_from_this()]() {
+            auto pHandle = pWeakHandle.lock();
+            if (pHandle)
+                pLoop->m_pTimerWheel->Remove(pHandle.get());
+        });
+    }
+
     LoopThread::LoopThread(const char *threadName) : m_threadName(threadName) {}
 
     LoopThread::~LoopThread() {
@@ -13,11 +24,20 @@ namespace WAMR_EXT_NS {
         if (m_bRunning)
             return;
         uv_loop_init(&m_uvloop);
-        uv_async_init(&m_uvloop, &m_uvAsync, nullptr);
+        uv_async_init(&m_uvloop, &m_uvAsync, [](uv_async_t* pUVAsync) {
+            ((LoopThread*)pUVAsync->data)->OnAsync();
+        });
+        m_uvAsync.data = this;
+        uv_timer_init(&m_uvloop, &m_uvTimer);
+        m_uvTimer.data = this;
+        m_bLoopClosing = false;
+        m_pTimerWheel = std::make_unique<TimerWheel>(uv_now(&m_uvloop));
+        m_uvTimerDueTick = UINT64_MAX;
         m_pThread = std::make_shared<std::thread>([this]() {
             Utility::SetCurrentThreadName(m_threadName.c_str());
             uv_run(&m_uvloop, UV_RUN_DEFAULT);
         });
+        m_threadID = m_pThread->get_id();
         m_bRunning = true;
     }
 
@@ -25,48 +45,124 @@ namespace WAMR_EXT_NS {
         std::lock_guard<std::mutex> _al(m_lock);
         if (!m_bRunning)
             return;
-        uv_walk(&m_uvloop, [](uv_handle_t* pUVHandle, void*) {
-            uv_close(pUVHandle, &LoopThread::DestroyUVHandleData);
-        }, nullptr);
+        m_bRunning = false;
+        m_opQueue.Push([this]() {
+            m_bLoopClosing = true;
+            uv_close((uv_handle_t*)&m_uvTimer, nullptr);
+            uv_close((uv_handle_t*)&m_uvAsync, nullptr);
+        });
         uv_async_send(&m_uvAsync);
         m_pThread->join();
+        m_threadID = std::thread::id();
+        // Discard operations submitted while stopping
+        m_opQueue.DrainAll([](std::function<void()>&) {});
         int ret = uv_loop_close(&m_uvloop);
         assert(ret == 0);
+        m_pTimerWheel.reset();
         m_pThread.reset();
-        m_bRunning = false;
     }
 
-    bool LoopThread::PostTimerTask(const std::function<void()> &cb, uint64_t delay, uint64_t repeatInterval) {
-        std::lock_guard<std::mutex> _al(m_lock);
-        if (!m_bRunning)
-            return false;
-        return DoPostTimerTask(cb, delay, repeatInterval);
-    }
-
-    bool LoopThread::DoPostTimerTask(const std::function<void()> &cb, uint64_t delay, uint64_t repeatInterval) {
-        auto* pData = new UVHandleTimerData(this, &m_uvloop, cb);
-        if (uv_timer_start(&pData->uvHandle.timer, [](uv_timer_t* pUVTimer) {
-            auto* pData = (UVHandleTimerData*)pUVTimer;
-            pData->cb();
-            uv_update_time(pUVTimer->loop);
-            if (uv_timer_get_repeat(pUVTimer) == 0)
-                uv_close((uv_handle_t*)pUVTimer, &LoopThread::DestroyUVHandleData);
-        }, delay, repeatInterval) != 0) {
-            delete pData;
+    void LoopThread::PushOp(std::function<void()>&& op) {
+        // Only the first operation of a batch needs to wake up the loop
+        if (m_opQueue.Push(std::move(op)))
+            uv_async_send(&m_uvAsync);
+    }
+
+    bool LoopThread::PostTask(std::function<void()> task) {
+        if (!m_bRunning.load(std::memory_order_acquire))
             return false;
-        }
-        uv_async_send(&m_uvAsync);
+        PushOp(std::move(task));
         return true;
     }
 
-    void LoopThread::DestroyUVHandleData(uv_handle_t *pUVHandle) {
-        if (pUVHandle->type == UV_TIMER) {
-            auto *pData = (UVHandleTimerData*)pUVHandle;
-            delete pData;
-        } else if (pUVHandle->type == UV_ASYNC) {
+    bool LoopThread::PostTaskAndReply(std::function<void()> task, std::function<void()> reply, LoopThread* replyLoop) {
+        if (!replyLoop)
+            replyLoop = this;
+        return PostTask([task = std::move(task), reply = std::move(reply), replyLoop]() mutable {
+            task();
+            replyLoop->PostTask(std::move(reply));
+        });
+    }
+
+    std::shared_ptr<TimerHandle> LoopThread::PostTimerTask(const std::function<void()> &cb, uint64_t delay, uint64_t repeatInterval) {
+        if (!m_bRunning.load(std::memory_order_acquire))
+            return nullptr;
+        std::shared_ptr<TimerHandle> pHandle(new TimerHandle(this, cb, delay, repeatInterval));
+        PushOp([this, pHandle]() {
+            // Cancelled before being added, its removal has run already
+            if (pHandle->IsCancelled())
+                return;
+            uv_update_time(&m_uvloop);
+            pHandle->expireTick = uv_now(&m_uvloop) + pHandle->delay;
+            m_pTimerWheel->Add(pHandle);
+        });
+        return pHandle;
+    }
+
+    void LoopThread::OnAsync() {
+        m_opQueue.DrainAll([](std::function<void()>& op) {
+            op();
+        });
+        UpdateUVTimer();
+    }
+
+    void LoopThread::OnTimer() {
+        m_uvTimerDueTick = UINT64_MAX;
+        std::vector<std::shared_ptr<TimerWheelEntry>> expiredEntries;
+        m_pTimerWheel->Advance(uv_now(&m_uvloop), expiredEntries);
+        for (auto& pEntry : expiredEntries) {
+            auto* pHandle = static_cast<TimerHandle*>(pEntry.get());
+            if (pHandle->IsCancelled())
+                continue;
+            pHandle->cb();
+            if (pHandle->repeatInterval > 0 && !pHandle->IsCancelled()) {
+                uv_update_time(&m_uvloop);
+                pHandle->expireTick = uv_now(&m_uvloop) + pHandle->repeatInterval;
+                m_pTimerWheel->Add(pEntry);
+            }
+        }
+        UpdateUVTimer();
+    }
+
+    // Only one uv timer is armed for the earliest event of the timer wheel
+    void LoopThread::UpdateUVTimer() {
+        if (m_bLoopClosing)
+            return;
+        uint64_t nextTick = m_pTimerWheel->GetNextEventTick();
+        if (nextTick == m_uvTimerDueTick)
+            return;
+        m_uvTimerDueTick = nextTick;
+        if (nextTick == UINT64_MAX) {
+            uv_timer_stop(&m_uvTimer);
             return;
-        } else {
-            assert(false);
         }
+        uint64_t now = uv_now(&m_uvloop);
+        uv_timer_start(&m_uvTimer, [](uv_timer_t* pUVTimer) {
+            ((LoopThread*)pUVTimer->data)->OnTimer();
+        }, nextTick > now ? nextTick - now : 0, 0);
+    }
+
+    LoopThreadPool::LoopThreadPool(const char* threadNamePrefix, uint32_t threadCount) {
+        threadCount = std::max<uint32_t>(threadCount, 1);
+        for (uint32_t i = 0; i < threadCount; i++)
+            m_loopThreads.emplace_back(std::make_unique<LoopThread>((threadNamePrefix + std::to_string(i)).c_str()));
+    }
+
+    void LoopThreadPool::Start() {
+        for (auto& pLoopThread : m_loopThreads)
+            pLoopThread->Start();
+    }
+
+    void LoopThreadPool::Stop() {
+        for (auto& pLoopThread : m_loopThreads)
+            pLoopThread->Stop();
+    }
+
+    LoopThread& LoopThreadPool::GetLoopThread(uintptr_t hint) {
+        return *m_loopThreads[(hint ^ (hint >> 16)) % m_loopThreads.size()];
+    }
+
+    LoopThread& LoopThreadPool::GetNextLoopThread() {
+        return *m_loopThreads[m_nextIndex.fetch_add(1, std::memory_order_relaxed) % m_loopThreads.size()];
     }
 }
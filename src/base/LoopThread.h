@@ -1,9 +1,31 @@
 #pragma once
 #include "BaseDef.h"
+#include "MPSCQueue.h"
+#include "TimerWheel.h"
 #include <thread>
 #include <uv.h>
 
 namespace WAMR_EXT_NS{
+    class LoopThread;
+
+    class TimerHandle : public TimerWheelEntry, public std::enable_shared_from_this<TimerHandle> {
+    public:
+        // The callback won't be called after Cancel() returns, unless it is running in the loop thread now.
+        // The timer is removed from the wheel of the loop thread asynchronously.
+        void Cancel();
+        bool IsCancelled() const { return m_bCancelled.load(std::memory_order_acquire); }
+    private:
+        friend class LoopThread;
+        TimerHandle(LoopThread* _pLoop, const std::function<void()>& _cb, uint64_t _delay, uint64_t _repeatInterval) :
+            pLoop(_pLoop), cb(_cb), delay(_delay), repeatInterval(_repeatInterval) {}
+
+        LoopThread* pLoop;
+        std::function<void()> cb;
+        uint64_t delay;
+        uint64_t repeatInterval;
+        std::atomic<bool> m_bCancelled{false};
+    };
+
     class LoopThread {
     public:
         LoopThread(const char* threadName);
@@ -11,35 +33,52 @@ namespace WAMR_EXT_NS{
 
         void Start();
         void Stop();
-        bool PostTimerTask(const std::function<void()>& cb, uint64_t delay, uint64_t repeatInterval);
+        // Run the task in the loop thread, return false if the loop thread is not running
+        bool PostTask(std::function<void()> task);
+        // Run the task in the loop thread, then run the reply in replyLoop(this loop thread if null).
+        // The reply is dropped if replyLoop has been stopped.
+        bool PostTaskAndReply(std::function<void()> task, std::function<void()> reply, LoopThread* replyLoop = nullptr);
+        // Return nullptr if the loop thread is not running
+        std::shared_ptr<TimerHandle> PostTimerTask(const std::function<void()>& cb, uint64_t delay, uint64_t repeatInterval);
+        bool IsCurrentThread() const { return m_threadID == std::this_thread::get_id(); }
     private:
-        struct UVHandleBaseData {
-            union {
-                uv_timer_t timer;
-            } uvHandle;
-            LoopThread* pThisThread;
-
-            UVHandleBaseData(LoopThread* _pThisThread) : pThisThread(_pThisThread) {}
-            UVHandleBaseData(const UVHandleBaseData&) = delete;
-            UVHandleBaseData& operator=(const UVHandleBaseData&) = delete;
-        };
-
-        struct UVHandleTimerData : public UVHandleBaseData {
-            std::function<void()> cb;
-            UVHandleTimerData(LoopThread* pThisThread, uv_loop_t* pLoop, const std::function<void()>& _cb) :
-                UVHandleBaseData(pThisThread), cb(_cb) {
-                uv_timer_init(pLoop, &uvHandle.timer);
-            }
-        };
-
-        static void DestroyUVHandleData(uv_handle_t* pUVHandle);
-        bool DoPostTimerTask(const std::function<void()>& cb, uint64_t delay, uint64_t repeatInterval);
+        friend class TimerHandle;
+        void PushOp(std::function<void()>&& op);
+        // Run in the loop thread
+        void OnAsync();
+        void OnTimer();
+        void UpdateUVTimer();
 
         std::string m_threadName;
         std::shared_ptr<std::thread> m_pThread;
+        std::thread::id m_threadID;
         std::mutex m_lock;
-        bool m_bRunning{false};
+        std::atomic<bool> m_bRunning{false};
         uv_loop_t m_uvloop;
         uv_async_t m_uvAsync;
+        uv_timer_t m_uvTimer;
+        // Operations submitted by other threads, executed in the loop thread
+        MPSCQueue<std::function<void()>> m_opQueue;
+        // Accessed only in the loop thread
+        std::unique_ptr<TimerWheel> m_pTimerWheel;
+        uint64_t m_uvTimerDueTick{UINT64_MAX};
+        bool m_bLoopClosing{false};
+    };
+
+    // Fixed number of loop threads, timers and tasks are spread over them
+    class LoopThreadPool {
+    public:
+        LoopThreadPool(const char* threadNamePrefix, uint32_t threadCount);
+        LoopThreadPool(const LoopThreadPool&) = delete;
+        LoopThreadPool& operator=(const LoopThreadPool&) = delete;
+
+        void Start();
+        void Stop();
+        // The same hint always selects the same loop thread
+        LoopThread& GetLoopThread(uintptr_t hint);
+        LoopThread& GetNextLoopThread();
+    private:
+        std::vector<std::unique_ptr<LoopThread>> m_loopThreads;
+        std::atomic<uint32_t> m_nextIndex{0};
     };
 }
@@ -0,0 +1,68 @@
+#pragma once
+#include "BaseDef.h"
+
+namespace WAMR_EXT_NS {
+    // Lock-free multi-producer single-consumer queue, producers push onto an atomic list head and
+    // the consumer takes all pending items at once.
+    template<typename T>
+    class MPSCQueue {
+    public:
+        MPSCQueue() = default;
+        ~MPSCQueue() {
+            DeleteNodes(m_pHead.exchange(nullptr, std::memory_order_acquire));
+        }
+        MPSCQueue(const MPSCQueue&) = delete;
+        MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+        // Return true if the queue was empty before pushing, the consumer only needs to be woken up in this case
+        bool Push(T value) {
+            auto* pNode = new Node(std::move(value));
+            Node* pOldHead = m_pHead.load(std::memory_order_relaxed);
+            do {
+                pNode->pNext = pOldHead;
+            } while (!m_pHead.compare_exchange_weak(pOldHead, pNode, std::memory_order_release, std::memory_order_relaxed));
+            return pOldHead == nullptr;
+        }
+
+        // Take all pending items in FIFO order, must be called only by the consumer
+        template<typename F>
+        size_t DrainAll(const F& func) {
+            Node* pNode = m_pHead.exchange(nullptr, std::memory_order_acquire);
+            // Reverse the list to restore the pushing order
+            Node* pReversed = nullptr;
+            while (pNode) {
+                Node* pNext = pNode->pNext;
+                pNode->pNext = pReversed;
+                pReversed = pNode;
+                pNode = pNext;
+            }
+            size_t count = 0;
+            while (pReversed) {
+                Node* pNext = pReversed->pNext;
+                func(pReversed->value);
+                delete pReversed;
+                pReversed = pNext;
+                count++;
+            }
+            return count;
+        }
+
+        bool Empty() const { return m_pHead.load(std::memory_order_acquire) == nullptr; }
+    private:
+        struct Node {
+            T value;
+            Node* pNext{nullptr};
+            explicit Node(T&& _value) : value(std::move(_value)) {}
+        };
+
+        static void DeleteNodes(Node* pNode) {
+            while (pNode) {
+                Node* pNext = pNode->pNext;
+                delete pNode;
+                pNode = pNext;
+            }
+        }
+
+        std::atomic<Node*> m_pHead{nullptr};
+    };
+}
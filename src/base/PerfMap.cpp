@@ -0,0 +1,24 @@
+#include "PerfMap.h"
+#include "Utility.h"
+
+namespace WAMR_EXT_NS {
+    std::mutex PerfMap::m_gLock;
+    FILE* PerfMap::m_gFile = nullptr;
+
+    void PerfMap::AddSymbols(const std::vector<Symbol>& symbols) {
+#ifndef _WIN32
+        std::lock_guard<std::mutex> _al(m_gLock);
+        if (!m_gFile) {
+            char filePath[64];
+            snprintf(filePath, sizeof(filePath), "/tmp/perf-%u.map", Utility::GetProcessID());
+            // Kept open until the process exits, profilers read it after the process ends
+            m_gFile = fopen(filePath, "a");
+            if (!m_gFile)
+                return;
+        }
+        for (const auto& symbol : symbols)
+            fprintf(m_gFile, "%" PRIxPTR " %zx %s\n", symbol.addr, symbol.size, symbol.name.c_str());
+        fflush(m_gFile);
+#endif
+    }
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include "BaseDef.h"
+
+namespace WAMR_EXT_NS {
+    // Symbols of generated code appended to /tmp/perf-<pid>.map, which is read by Linux perf and other profilers
+    class PerfMap {
+    public:
+        struct Symbol {
+            uintptr_t addr;
+            size_t size;
+            std::string name;
+        };
+
+        static void AddSymbols(const std::vector<Symbol>& symbols);
+    private:
+        static std::mutex m_gLock;
+        static FILE* m_gFile;
+    };
+}
@@ -0,0 +1,52 @@
+#include "RingBufferAllocator.h"
+#include <algorithm>
+
+namespace WAMR_EXT_NS {
+    bool RingBufferAllocator::Acquire(uint32_t size, uint32_t& outOffset) {
+        if (size == 0 || size > m_capacity)
+            return false;
+        uint64_t alignedSize = ((uint64_t)size + BLOCK_ALIGNMENT - 1) & ~(uint64_t)(BLOCK_ALIGNMENT - 1);
+        uint32_t offset = 0;
+        if (!m_blocks.empty()) {
+            const auto& firstBlock = m_blocks.front();
+            const auto& lastBlock = m_blocks.back();
+            uint64_t tail = (uint64_t)lastBlock.offset + lastBlock.size;
+            if (lastBlock.offset >= firstBlock.offset) {
+                // Free space: [tail, capacity) and [0, head)
+                if (m_capacity - tail >= alignedSize)
+                    offset = tail;
+                else if (firstBlock.offset >= alignedSize)
+                    offset = 0;
+                else
+                    return false;
+            } else {
+                // Wrapped, free space: [tail, head)
+                if (firstBlock.offset - tail >= alignedSize)
+                    offset = tail;
+                else
+                    return false;
+            }
+        }
+        if (offset + alignedSize > m_capacity) {
+            // Only the last block may be shorter than the alignment
+            if (offset + size > m_capacity)
+                return false;
+            alignedSize = m_capacity - offset;
+        }
+        m_blocks.push_back({offset, (uint32_t)alignedSize, false});
+        outOffset = offset;
+        return true;
+    }
+
+    bool RingBufferAllocator::Release(uint32_t offset) {
+        auto it = std::find_if(m_blocks.begin(), m_blocks.end(), [offset](const Block& block) {
+            return block.offset == offset && !block.bReleased;
+        });
+        if (it == m_blocks.end())
+            return false;
+        it->bReleased = true;
+        while (!m_blocks.empty() && m_blocks.front().bReleased)
+            m_blocks.pop_front();
+        return true;
+    }
+}
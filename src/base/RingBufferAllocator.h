@@ -0,0 +1,32 @@
+#pragma once
+#include "BaseDef.h"
+#include <deque>
+
+namespace WAMR_EXT_NS {
+    // Allocate contiguous blocks from a fixed range in FIFO order, blocks may be released in any order
+    // but the space is reused only after all earlier blocks are released. It is not thread-safe.
+    class RingBufferAllocator {
+    public:
+        explicit RingBufferAllocator(uint32_t capacity) : m_capacity(capacity) {}
+        RingBufferAllocator(const RingBufferAllocator&) = delete;
+        RingBufferAllocator& operator=(const RingBufferAllocator&) = delete;
+
+        // Return false if there is no enough contiguous space
+        bool Acquire(uint32_t size, uint32_t& outOffset);
+        // Return false if no live block starts at offset
+        bool Release(uint32_t offset);
+        uint32_t GetCapacity() const { return m_capacity; }
+    private:
+        static constexpr uint32_t BLOCK_ALIGNMENT = 16;
+
+        struct Block {
+            uint32_t offset;
+            uint32_t size;
+            bool bReleased;
+        };
+
+        uint32_t m_capacity;
+        // In order of allocation
+        std::deque<Block> m_blocks;
+    };
+}
@@ -0,0 +1,102 @@
+#include "SHA256.h"
+
+namespace WAMR_EXT_NS {
+    static const uint32_t SHA256_K[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+    };
+
+    static inline uint32_t RotateRight(uint32_t x, uint32_t n) {
+        return (x >> n) | (x << (32 - n));
+    }
+
+    SHA256::SHA256() : m_state{0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19} {}
+
+    void SHA256::Transform(const uint8_t* pBlock) {
+        uint32_t w[64];
+        for (uint32_t i = 0; i < 16; i++)
+            w[i] = uint32_t(pBlock[i * 4]) << 24 | uint32_t(pBlock[i * 4 + 1]) << 16 | uint32_t(pBlock[i * 4 + 2]) << 8 | pBlock[i * 4 + 3];
+        for (uint32_t i = 16; i < 64; i++) {
+            uint32_t s0 = RotateRight(w[i - 15], 7) ^ RotateRight(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = RotateRight(w[i - 2], 17) ^ RotateRight(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        uint32_t a = m_state[0], b = m_state[1], c = m_state[2], d = m_state[3];
+        uint32_t e = m_state[4], f = m_state[5], g = m_state[6], h = m_state[7];
+        for (uint32_t i = 0; i < 64; i++) {
+            uint32_t t1 = h + (RotateRight(e, 6) ^ RotateRight(e, 11) ^ RotateRight(e, 25)) + ((e & f) ^ (~e & g)) + SHA256_K[i] + w[i];
+            uint32_t t2 = (RotateRight(a, 2) ^ RotateRight(a, 13) ^ RotateRight(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+        m_state[0] += a; m_state[1] += b; m_state[2] += c; m_state[3] += d;
+        m_state[4] += e; m_state[5] += f; m_state[6] += g; m_state[7] += h;
+    }
+
+    void SHA256::Update(const void* pData, size_t size) {
+        auto* p = static_cast<const uint8_t*>(pData);
+        m_totalLen += size;
+        if (m_bufferLen > 0) {
+            size_t copyLen = std::min(size, sizeof(m_buffer) - m_bufferLen);
+            memcpy(m_buffer + m_bufferLen, p, copyLen);
+            m_bufferLen += copyLen;
+            p += copyLen;
+            size -= copyLen;
+            if (m_bufferLen < sizeof(m_buffer))
+                return;
+            Transform(m_buffer);
+            m_bufferLen = 0;
+        }
+        for (; size >= sizeof(m_buffer); p += sizeof(m_buffer), size -= sizeof(m_buffer))
+            Transform(p);
+        memcpy(m_buffer, p, size);
+        m_bufferLen = size;
+    }
+
+    SHA256::Digest SHA256::Final() {
+        uint64_t totalBits = m_totalLen * 8;
+        uint8_t padding[72] = {0x80};
+        size_t paddingLen = (m_bufferLen < 56 ? 56 : 120) - m_bufferLen;
+        for (uint32_t i = 0; i < 8; i++)
+            padding[paddingLen + i] = uint8_t(totalBits >> (56 - i * 8));
+        Update(padding, paddingLen + 8);
+        assert(m_bufferLen == 0);
+        Digest digest;
+        for (uint32_t i = 0; i < 8; i++) {
+            digest[i * 4] = uint8_t(m_state[i] >> 24);
+            digest[i * 4 + 1] = uint8_t(m_state[i] >> 16);
+            digest[i * 4 + 2] = uint8_t(m_state[i] >> 8);
+            digest[i * 4 + 3] = uint8_t(m_state[i]);
+        }
+        return digest;
+    }
+
+    SHA256::Digest SHA256::Hash(const void* pData, size_t size) {
+        SHA256 sha256;
+        sha256.Update(pData, size);
+        return sha256.Final();
+    }
+
+    std::string SHA256::ToHex(const Digest& digest) {
+        static const char hexChars[] = "0123456789abcdef";
+        std::string ret;
+        ret.reserve(digest.size() * 2);
+        for (uint8_t b : digest) {
+            ret.push_back(hexChars[b >> 4]);
+            ret.push_back(hexChars[b & 0xf]);
+        }
+        return ret;
+    }
+}
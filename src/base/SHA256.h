@@ -0,0 +1,26 @@
+#pragma once
+#include "BaseDef.h"
+#include <array>
+
+namespace WAMR_EXT_NS {
+    // SHA-256(FIPS 180-4), used where a content hash must not be forgeable, e.g. identifying module code
+    class SHA256 {
+    public:
+        typedef std::array<uint8_t, 32> Digest;
+
+        SHA256();
+        void Update(const void* pData, size_t size);
+        Digest Final();
+
+        static Digest Hash(const void* pData, size_t size);
+        // Lowercase hex string of 64 characters
+        static std::string ToHex(const Digest& digest);
+    private:
+        void Transform(const uint8_t* pBlock);
+
+        uint32_t m_state[8];
+        uint8_t m_buffer[64];
+        size_t m_bufferLen{0};
+        uint64_t m_totalLen{0};
+    };
+}
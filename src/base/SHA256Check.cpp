@@ -0,0 +1,34 @@
+#include "SHA256.h"
+
+// Run after building to check SHA256 against the test vectors of FIPS 180-2, a wrong digest would share wrong modules
+// and load stale AOT files silently
+using namespace WAMR_EXT_NS;
+
+static bool CheckDigest(const char* name, const SHA256::Digest& digest, const char* expectedHex) {
+    std::string hex = SHA256::ToHex(digest);
+    if (hex == expectedHex)
+        return true;
+    fprintf(stderr, "SHA-256 of %s is %s, expected %s\n", name, hex.c_str(), expectedHex);
+    return false;
+}
+
+int main() {
+    bool bPassed = true;
+    bPassed &= CheckDigest("\"\"", SHA256::Hash("", 0),
+                           "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    bPassed &= CheckDigest("\"abc\"", SHA256::Hash("abc", 3),
+                           "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    const char* msg448 = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    bPassed &= CheckDigest("the 448-bit message", SHA256::Hash(msg448, strlen(msg448)),
+                           "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+    // Fed in pieces of different sizes to cover buffering across blocks
+    std::string millionA(1000000, 'a');
+    SHA256 sha256;
+    for (size_t pos = 0, pieceSize = 1; pos < millionA.size(); pos += pieceSize, pieceSize = pieceSize % 97 + 1)
+        sha256.Update(millionA.data() + pos, std::min(pieceSize, millionA.size() - pos));
+    bPassed &= CheckDigest("1,000,000 'a'", sha256.Final(),
+                           "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+    bPassed &= CheckDigest("1,000,000 'a' at once", SHA256::Hash(millionA.data(), millionA.size()),
+                           "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+    return bPassed ? 0 : 1;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include "BaseDef.h"
+
+namespace WAMR_EXT_NS {
+    // Registry of shared objects keyed by their addresses, split into shards with separate locks
+    // so that concurrent insertions, removals and iterations rarely contend with each other.
+    template<typename T, size_t ShardCount = 16>
+    class ShardedRegistry {
+    public:
+        ShardedRegistry() = default;
+        ShardedRegistry(const ShardedRegistry&) = delete;
+        ShardedRegistry& operator=(const ShardedRegistry&) = delete;
+
+        void Insert(const std::shared_ptr<T>& pObj) {
+            auto& shard = GetShard(pObj.get());
+            std::lock_guard<std::mutex> _al(shard.lock);
+            shard.objMap.emplace(pObj.get(), pObj);
+        }
+
+        // Return the removed object, so that it can be released outside of the shard lock
+        std::shared_ptr<T> Remove(const T* pObj) {
+            auto& shard = GetShard(pObj);
+            std::lock_guard<std::mutex> _al(shard.lock);
+            auto it = shard.objMap.find(pObj);
+            if (it == shard.objMap.end())
+                return nullptr;
+            auto pRemovedObj = std::move(it->second);
+            shard.objMap.erase(it);
+            return pRemovedObj;
+        }
+
+        // Call func on a snapshot of each shard without holding the shard lock,
+        // objects inserted or removed during the iteration may or may not be visited.
+        template<typename F>
+        void ForEach(const F& func) {
+            std::vector<std::shared_ptr<T>> snapshot;
+            for (auto& shard : m_shards) {
+                {
+                    std::lock_guard<std::mutex> _al(shard.lock);
+                    snapshot.reserve(shard.objMap.size());
+                    for (const auto& it : shard.objMap)
+                        snapshot.push_back(it.second);
+                }
+                for (const auto& pObj : snapshot)
+                    func(pObj);
+                snapshot.clear();
+            }
+        }
+
+        size_t Size() {
+            size_t size = 0;
+            for (auto& shard : m_shards) {
+                std::lock_guard<std::mutex> _al(shard.lock);
+                size += shard.objMap.size();
+            }
+            return size;
+        }
+    private:
+        struct alignas(64) Shard {
+            std::mutex lock;
+            std::unordered_map<const T*, std::shared_ptr<T>> objMap;
+        };
+
+        Shard& GetShard(const T* pObj) {
+            // Low bits of heap addresses are always zero because of the alignment
+            auto addr = reinterpret_cast<uintptr_t>(pObj);
+            return m_shards[((addr >> 4) ^ (addr >> 12)) % ShardCount];
+        }
+
+        Shard m_shards[ShardCount];
+    };
+}
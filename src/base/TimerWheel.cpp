@@ -0,0 +1,124 @@
+#include "TimerWheel.h"
+
+namespace WAMR_EXT_NS {
+    void TimerWheel::Add(const std::shared_ptr<TimerWheelEntry>& pEntry) {
+        assert(pEntry->wheelLevel < 0);
+        m_entryCount++;
+        Place(std::shared_ptr<TimerWheelEntry>(pEntry));
+    }
+
+    bool TimerWheel::Remove(TimerWheelEntry* pEntry) {
+        if (pEntry->wheelLevel < 0)
+            return false;
+        auto& entries = pEntry->wheelLevel == EXPIRED_LEVEL ? m_expiredEntries : m_levels[pEntry->wheelLevel].slots[pEntry->wheelSlot];
+        const size_t index = pEntry->wheelIndex;
+        assert(index < entries.size() && entries[index].get() == pEntry);
+        // Release the entry at last, it may hold the last reference
+        auto pRemoved = std::move(entries[index]);
+        if (index != entries.size() - 1) {
+            entries[index] = std::move(entries.back());
+            entries[index]->wheelIndex = index;
+        }
+        entries.pop_back();
+        if (entries.empty() && pEntry->wheelLevel != EXPIRED_LEVEL)
+            m_levels[pEntry->wheelLevel].slotBitmap &= ~(1ULL << pEntry->wheelSlot);
+        pEntry->wheelLevel = -1;
+        m_entryCount--;
+        return true;
+    }
+
+    void TimerWheel::PushEntry(std::vector<std::shared_ptr<TimerWheelEntry>>& entries, int32_t level, uint32_t slot,
+                               std::shared_ptr<TimerWheelEntry>&& pEntry) {
+        pEntry->wheelLevel = level;
+        pEntry->wheelSlot = slot;
+        pEntry->wheelIndex = entries.size();
+        entries.push_back(std::move(pEntry));
+    }
+
+    void TimerWheel::Place(std::shared_ptr<TimerWheelEntry>&& pEntry) {
+        const uint64_t expireTick = pEntry->expireTick;
+        if (expireTick <= m_curTick) {
+            PushEntry(m_expiredEntries, EXPIRED_LEVEL, 0, std::move(pEntry));
+            return;
+        }
+        uint32_t level = 0;
+        uint32_t slot = 0;
+        for (; level < LEVEL_COUNT; level++) {
+            const uint32_t shift = level * LEVEL_BITS;
+            if ((expireTick >> shift) - (m_curTick >> shift) < LEVEL_SLOT_COUNT) {
+                slot = (expireTick >> shift) & (LEVEL_SLOT_COUNT - 1);
+                break;
+            }
+        }
+        if (level == LEVEL_COUNT) {
+            // Out of range, park it in the farthest slot of the top level and place it again after cascaded
+            level = LEVEL_COUNT - 1;
+            slot = ((m_curTick >> (level * LEVEL_BITS)) + LEVEL_SLOT_COUNT - 1) & (LEVEL_SLOT_COUNT - 1);
+        }
+        auto& wheelLevel = m_levels[level];
+        PushEntry(wheelLevel.slots[slot], level, slot, std::move(pEntry));
+        wheelLevel.slotBitmap |= (1ULL << slot);
+    }
+
+    void TimerWheel::Cascade(uint32_t level) {
+        auto& wheelLevel = m_levels[level];
+        const uint32_t slot = (m_curTick >> (level * LEVEL_BITS)) & (LEVEL_SLOT_COUNT - 1);
+        if (!(wheelLevel.slotBitmap & (1ULL << slot)))
+            return;
+        std::vector<std::shared_ptr<TimerWheelEntry>> entries;
+        entries.swap(wheelLevel.slots[slot]);
+        wheelLevel.slotBitmap &= ~(1ULL << slot);
+        for (auto& pEntry : entries)
+            Place(std::move(pEntry));
+    }
+
+    uint64_t TimerWheel::GetNextEventTick() const {
+        if (!m_expiredEntries.empty())
+            return m_curTick;
+        uint64_t nextTick = UINT64_MAX;
+        for (uint32_t level = 0; level < LEVEL_COUNT; level++) {
+            const uint64_t bitmap = m_levels[level].slotBitmap;
+            if (bitmap == 0)
+                continue;
+            const uint32_t shift = level * LEVEL_BITS;
+            // Find the nearest non-empty slot after the current one
+            const uint32_t startSlot = ((m_curTick >> shift) + 1) & (LEVEL_SLOT_COUNT - 1);
+            const uint64_t rotatedBitmap = (bitmap >> startSlot) | (bitmap << ((LEVEL_SLOT_COUNT - startSlot) & (LEVEL_SLOT_COUNT - 1)));
+            const uint64_t distance = __builtin_ctzll(rotatedBitmap) + 1;
+            nextTick = std::min(nextTick, ((m_curTick >> shift) + distance) << shift);
+        }
+        return nextTick;
+    }
+
+    void TimerWheel::Advance(uint64_t nowTick, std::vector<std::shared_ptr<TimerWheelEntry>>& expiredEntries) {
+        while (true) {
+            if (!m_expiredEntries.empty()) {
+                m_entryCount -= m_expiredEntries.size();
+                for (auto& pEntry : m_expiredEntries) {
+                    pEntry->wheelLevel = -1;
+                    expiredEntries.push_back(std::move(pEntry));
+                }
+                m_expiredEntries.clear();
+            }
+            const uint64_t nextTick = GetNextEventTick();
+            if (nextTick > nowTick)
+                break;
+            m_curTick = nextTick;
+            // Cascade from the top level, so that entries can fall through multiple levels at the same tick
+            for (uint32_t level = LEVEL_COUNT - 1; level > 0; level--) {
+                if ((m_curTick & ((1ULL << (level * LEVEL_BITS)) - 1)) == 0)
+                    Cascade(level);
+            }
+            auto& firstLevel = m_levels[0];
+            const uint32_t slot = m_curTick & (LEVEL_SLOT_COUNT - 1);
+            if (firstLevel.slotBitmap & (1ULL << slot)) {
+                for (auto& pEntry : firstLevel.slots[slot])
+                    PushEntry(m_expiredEntries, EXPIRED_LEVEL, 0, std::move(pEntry));
+                firstLevel.slots[slot].clear();
+                firstLevel.slotBitmap &= ~(1ULL << slot);
+            }
+        }
+        if (nowTick > m_curTick)
+            m_curTick = nowTick;
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include "BaseDef.h"
+
+namespace WAMR_EXT_NS {
+    struct TimerWheelEntry {
+        uint64_t expireTick{0};
+        virtual ~TimerWheelEntry() = default;
+    private:
+        friend class TimerWheel;
+        // Position in the wheel for removal in O(1), level is -1 if the entry is not in the wheel
+        int32_t wheelLevel{-1};
+        uint32_t wheelSlot{0};
+        size_t wheelIndex{0};
+    };
+
+    // Hierarchical timer wheel with 4 levels of 64 slots, each slot of level N covers 64^N ticks.
+    // Entries are cascaded to lower levels when their slot is reached, idle ranges are skipped at once.
+    // It is not thread-safe and is meant to be driven by a single loop thread.
+    class TimerWheel {
+    public:
+        explicit TimerWheel(uint64_t curTick = 0) : m_curTick(curTick) {}
+        TimerWheel(const TimerWheel&) = delete;
+        TimerWheel& operator=(const TimerWheel&) = delete;
+
+        void Add(const std::shared_ptr<TimerWheelEntry>& pEntry);
+        // Return false if the entry is not in the wheel, e.g. it has expired
+        bool Remove(TimerWheelEntry* pEntry);
+        // Move current tick to nowTick and collect all expired entries
+        void Advance(uint64_t nowTick, std::vector<std::shared_ptr<TimerWheelEntry>>& expiredEntries);
+        // Return the earliest tick at which Advance() needs to be called, or UINT64_MAX if the wheel is empty.
+        // It may be earlier than the real expiration for entries in higher levels.
+        uint64_t GetNextEventTick() const;
+        uint64_t GetCurrentTick() const { return m_curTick; }
+        size_t Size() const { return m_entryCount; }
+    private:
+        static constexpr uint32_t LEVEL_BITS = 6;
+        static constexpr uint32_t LEVEL_SLOT_COUNT = 1 << LEVEL_BITS;
+        static constexpr uint32_t LEVEL_COUNT = 4;
+
+        struct Level {
+            uint64_t slotBitmap{0};
+            std::vector<std::shared_ptr<TimerWheelEntry>> slots[LEVEL_SLOT_COUNT];
+        };
+
+        void Place(std::shared_ptr<TimerWheelEntry>&& pEntry);
+        void PushEntry(std::vector<std::shared_ptr<TimerWheelEntry>>& entries, int32_t level, uint32_t slot,
+                       std::shared_ptr<TimerWheelEntry>&& pEntry);
+        void Cascade(uint32_t level);
+
+        uint64_t m_curTick;
+        size_t m_entryCount{0};
+        Level m_levels[LEVEL_COUNT];
+        // Level of entries in m_expiredEntries
+        static constexpr int32_t EXPIRED_LEVEL = LEVEL_COUNT;
+        std::vector<std::shared_ptr<TimerWheelEntry>> m_expiredEntries;
+    };
+}
@@ -2,12 +2,15 @@
 #ifdef __linux__
 #include <syscall.h>
 #include <sys/prctl.h>
+#include <linux/futex.h>
 #elif defined(__CYGWIN__)
 #include <windows.h>
 #endif
 #ifndef _WIN32
 #include <pthread.h>
+#include <sys/mman.h>
 #endif
+#include <thread>
 
 namespace WAMR_EXT_NS {
     thread_local char Utility::g_currentThreadName[64] = {0};
@@ -80,6 +83,28 @@ namespace WAMR_EXT_NS {
         return g_currentThreadName;
     }
 
+    uint64_t Utility::GetCurrentThreadCPUTimeNs() {
+#ifdef _WIN32
+        FILETIME creationTime, exitTime, kernelTime, userTime;
+        if (!GetThreadTimes(GetCurrentThread(), &creationTime, &exitTime, &kernelTime, &userTime))
+            return 0;
+        // FILETIME is in 100-nanosecond intervals
+        return ((uint64_t(kernelTime.dwHighDateTime) << 32 | kernelTime.dwLowDateTime) +
+                (uint64_t(userTime.dwHighDateTime) << 32 | userTime.dwLowDateTime)) * 100;
+#else
+        return GetThreadCPUTimeNs(CLOCK_THREAD_CPUTIME_ID);
+#endif
+    }
+
+#ifndef _WIN32
+    uint64_t Utility::GetThreadCPUTimeNs(clockid_t clockID) {
+        timespec ts;
+        if (clock_gettime(clockID, &ts) != 0)
+            return 0;
+        return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    }
+#endif
+
     uvwasi_errno_t Utility::GetHostFDByAppFD(wasm_module_inst_t pWasmModuleInst, int32_t appFD, uv_os_fd_t &outHostFD,
                                              const std::function<void(const uvwasi_fd_wrap_t*)> &cb) {
         uvwasi_t *pUVWasi = &wasm_runtime_get_wasi_ctx(pWasmModuleInst)->uvwasi;
@@ -193,4 +218,52 @@ namespace WAMR_EXT_NS {
             return it->second;
         return UVWASI_ENOSYS;
     }
+
+    void Utility::FutexWait(std::atomic<uint32_t>& word, uint32_t expectedValue, uint64_t timeoutNs) {
+        static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t));
+#ifdef __linux__
+        timespec timeout;
+        if (timeoutNs != UINT64_MAX) {
+            timeout.tv_sec = timeoutNs / 1000000000;
+            timeout.tv_nsec = timeoutNs % 1000000000;
+        }
+        syscall(__NR_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expectedValue,
+                timeoutNs != UINT64_MAX ? &timeout : nullptr, nullptr, 0);
+#else
+        if (word.load() == expectedValue)
+            std::this_thread::sleep_for(std::chrono::nanoseconds(std::min<uint64_t>(timeoutNs, 1000000)));
+#endif
+    }
+
+    void Utility::FutexWakeAll(std::atomic<uint32_t>& word) {
+#ifdef __linux__
+        syscall(__NR_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#endif
+    }
+
+    uint64_t Utility::GetResidentSize(const void* pAddr, size_t size) {
+#ifndef _WIN32
+        static const uintptr_t pageSize = sysconf(_SC_PAGESIZE);
+        uintptr_t beginAddr = (uintptr_t)pAddr & ~(pageSize - 1);
+        uintptr_t endAddr = ((uintptr_t)pAddr + size + pageSize - 1) & ~(pageSize - 1);
+        // Query in chunks to bound the vector size for large memories
+        constexpr size_t CHUNK_PAGE_COUNT = 4096;
+#ifdef __linux__
+        unsigned char pageStates[CHUNK_PAGE_COUNT];
+#else
+        char pageStates[CHUNK_PAGE_COUNT];
+#endif
+        uint64_t residentPageCount = 0;
+        for (uintptr_t addr = beginAddr; addr < endAddr; addr += CHUNK_PAGE_COUNT * pageSize) {
+            size_t chunkSize = std::min<uintptr_t>(endAddr - addr, CHUNK_PAGE_COUNT * pageSize);
+            if (mincore((void*)addr, chunkSize, pageStates) != 0)
+                return 0;
+            for (size_t i = 0; i < chunkSize / pageSize; i++)
+                residentPageCount += pageStates[i] & 1;
+        }
+        return residentPageCount * pageSize;
+#else
+        return 0;
+#endif
+    }
 }
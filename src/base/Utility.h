@@ -11,9 +11,19 @@ namespace WAMR_EXT_NS {
         static uint32_t GetCurrentThreadID();
         static void SetCurrentThreadName(const char* name);
         static const char* GetCurrentThreadName();
+        static uint64_t GetCurrentThreadCPUTimeNs();
+#ifndef _WIN32
+        // CPU time of any thread in this process by its clock got from pthread_getcpuclockid(), 0 if failed
+        static uint64_t GetThreadCPUTimeNs(clockid_t clockID);
+#endif
         static uvwasi_errno_t GetHostFDByAppFD(wasm_module_inst_t pWasmModuleInst, int32_t appFD, uv_os_fd_t& outHostFD,
                                                const std::function<void(const uvwasi_fd_wrap_t*)>& cb = nullptr);
         static uvwasi_errno_t ConvertErrnoToWasiErrno(int err);
+        // Block the current thread while the value of word is equal to expectedValue, spurious wakeups are possible
+        static void FutexWait(std::atomic<uint32_t>& word, uint32_t expectedValue, uint64_t timeoutNs = UINT64_MAX);
+        static void FutexWakeAll(std::atomic<uint32_t>& word);
+        // Bytes of pages overlapping [pAddr, pAddr + size) resident in physical memory, 0 if unsupported
+        static uint64_t GetResidentSize(const void* pAddr, size_t size);
     private:
         static thread_local char g_currentThreadName[64];
     };
@@ -0,0 +1,61 @@
+#include "WorkerThreadPool.h"
+#include "Utility.h"
+
+namespace WAMR_EXT_NS {
+    WorkerThreadPool::WorkerThreadPool(const char* threadNamePrefix, uint32_t threadCount) :
+        m_threadNamePrefix(threadNamePrefix), m_threadCount(std::max<uint32_t>(threadCount, 1)) {}
+
+    WorkerThreadPool::~WorkerThreadPool() {
+        Stop();
+    }
+
+    void WorkerThreadPool::Start() {
+        std::lock_guard<std::mutex> _al(m_lock);
+        if (m_bRunning)
+            return;
+        m_bRunning = true;
+        for (uint32_t i = 0; i < m_threadCount; i++)
+            m_threads.emplace_back(&WorkerThreadPool::WorkerRoutine, this, i);
+    }
+
+    void WorkerThreadPool::Stop() {
+        std::vector<std::thread> threads;
+        {
+            std::lock_guard<std::mutex> _al(m_lock);
+            if (!m_bRunning)
+                return;
+            m_bRunning = false;
+            m_taskQueue.clear();
+            threads.swap(m_threads);
+        }
+        m_cond.notify_all();
+        for (auto& t : threads)
+            t.join();
+    }
+
+    bool WorkerThreadPool::PostTask(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> _al(m_lock);
+            if (!m_bRunning)
+                return false;
+            m_taskQueue.emplace_back(std::move(task));
+        }
+        m_cond.notify_one();
+        return true;
+    }
+
+    void WorkerThreadPool::WorkerRoutine(uint32_t index) {
+        Utility::SetCurrentThreadName((m_threadNamePrefix + std::to_string(index)).c_str());
+        std::unique_lock<std::mutex> _al(m_lock);
+        while (true) {
+            m_cond.wait(_al, [this]() { return !m_bRunning || !m_taskQueue.empty(); });
+            if (!m_bRunning)
+                break;
+            auto task = std::move(m_taskQueue.front());
+            m_taskQueue.pop_front();
+            _al.unlock();
+            task();
+            _al.lock();
+        }
+    }
+}
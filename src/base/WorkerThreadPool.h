@@ -0,0 +1,32 @@
+#pragma once
+#include "BaseDef.h"
+#include <thread>
+#include <deque>
+#include <condition_variable>
+
+namespace WAMR_EXT_NS {
+    // Fixed number of threads running blocking tasks in FIFO order
+    class WorkerThreadPool {
+    public:
+        WorkerThreadPool(const char* threadNamePrefix, uint32_t threadCount);
+        ~WorkerThreadPool();
+        WorkerThreadPool(const WorkerThreadPool&) = delete;
+        WorkerThreadPool& operator=(const WorkerThreadPool&) = delete;
+
+        void Start();
+        // Pending tasks are dropped
+        void Stop();
+        // Return false if the pool is not running
+        bool PostTask(std::function<void()> task);
+    private:
+        void WorkerRoutine(uint32_t index);
+
+        std::string m_threadNamePrefix;
+        uint32_t m_threadCount;
+        std::mutex m_lock;
+        std::condition_variable m_cond;
+        bool m_bRunning{false};
+        std::deque<std::function<void()>> m_taskQueue;
+        std::vector<std::thread> m_threads;
+    };
+}
@@ -6,15 +6,34 @@
 #include "../wamr_ext_lib/WasiSocketExt.h"
 #include "../wamr_ext_lib/WasiProcessExt.h"
 #include "../wamr_ext_lib/WasiMiscExt.h"
+#include "../wamr_ext_lib/WasiChannelExt.h"
+#include "../wamr_ext_lib/WamrExtProfiler.h"
 #include <wasm_runtime.h>
 #include <aot/aot_runtime.h>
 #include <mem_alloc.h>
+#include <algorithm>
 #include "../base/LoopThread.h"
+#include "../base/Completion.h"
+#include "../base/ShardedRegistry.h"
+#include "../base/WorkerThreadPool.h"
+#include "../base/CPUFeatures.h"
+#include "../base/PerfMap.h"
 
 namespace WAMR_EXT_NS {
     std::mutex gWasmLock;
-    LoopThread gLoopThread("wamr_ext_loop");
-    std::list<std::shared_ptr<WamrExtInstance>> gAllInstanceList;
+    // Timers and checks of instances, each instance is bound to one loop thread by its address
+    LoopThreadPool gInstanceLoopPool("wamr_ext_loop", std::max(2u, std::thread::hardware_concurrency() / 4));
+    // Exception callbacks are called here, so that slow callbacks don't delay timers of instances
+    LoopThread gCallbackLoop("wamr_ext_callback");
+    // Used for asynchronous function calls
+    WorkerThreadPool gCallWorkerPool("wamr_ext_worker", std::thread::hardware_concurrency());
+    ShardedRegistry<WamrExtInstance> gAllInstances;
+    // Content digest -> loaded module bodies, guarded by gWasmLock
+    std::map<SHA256::Digest, std::weak_ptr<WamrExtModuleBody>> gModuleBodyCache;
+    // Guarded by gWasmLock
+    std::filesystem::path gAOTCacheDir;
+    // Guarded by gWasmLock
+    bool gbPerfMapEnabled = false;
     std::unordered_map<wasi::wamr_ext_syscall_id, std::shared_ptr<ExtSyscallBase>> gExtSyscallMap;
 
     int32_t WamrExtSetInstanceOpt(WamrExtInstanceConfig& config, WamrExtInstanceOpt opt, const void* value) {
@@ -61,6 +80,31 @@ namespace WAMR_EXT_NS {
                     config.maxMemory = maxMem;
                 break;
             }
+            case WAMR_EXT_INST_OPT_MAX_CPU_TIME: {
+                config.maxCPUTime = *((uint64_t*)value);
+                break;
+            }
+            case WAMR_EXT_INST_OPT_EXEC_TIMEOUT: {
+                config.execTimeout = *((uint32_t*)value);
+                break;
+            }
+            case WAMR_EXT_INST_OPT_IO_BUFFER_SIZE: {
+                config.ioBufferSize = *((uint32_t*)value);
+                break;
+            }
+            case WAMR_EXT_INST_OPT_PGO_PROFILE_FILE: {
+                config.pgoProfileFile = (const char*)value;
+                break;
+            }
+            case WAMR_EXT_INST_OPT_ADD_CHANNEL: {
+                WamrExtChannelOpt* channelOpt = (WamrExtChannelOpt*)value;
+                if (!channelOpt->name) {
+                    ret = EINVAL;
+                    break;
+                }
+                config.channels[channelOpt->name] = channelOpt->capacity > 0 ? channelOpt->capacity : WAMR_EXT_DEFAULT_CHANNEL_CAPACITY;
+                break;
+            }
             default:
                 ret = EINVAL;
                 break;
@@ -76,23 +120,527 @@ namespace WAMR_EXT_NS {
         return 0;
     }
 
-    int32_t WamrExtModuleLoad(wamr_ext_module_t* module, const char* moduleName, const std::shared_ptr<uint8_t>& pModuleBuf, uint32_t len) {
+    // Fat AOT file generated by wamr-ext-aot.py with multiple profiles or --hw-bound-check, all integers are little-endian:
+    // magic(4B) | version(4B) | entry count(4B) | flags(4B, since version 2) | entries | AOT files
+    // entry: profile name(24B, NUL-terminated) | offset(4B) | size(4B), entries are sorted from the best profile
+    const uint8_t gFatAOTMagic[] = {'\0', 'w', 'f', 'a'};
+#define FAT_AOT_VERSION 2
+#define FAT_AOT_V1_HEADER_SIZE 12
+#define FAT_AOT_HEADER_SIZE 16
+#define FAT_AOT_PROFILE_NAME_SIZE 24
+#define FAT_AOT_ENTRY_SIZE (FAT_AOT_PROFILE_NAME_SIZE + 8)
+// AOT files are compiled without bounds checks for runtimes built with WAMR_EXT_HW_BOUND_CHECK
+#define FAT_AOT_FLAG_HW_BOUND_CHECK 1
+
+    bool IsFatAOT(const uint8_t* buf, uint32_t len) {
+        return len >= FAT_AOT_V1_HEADER_SIZE && memcmp(buf, gFatAOTMagic, sizeof(gFatAOTMagic)) == 0;
+    }
+
+    // Select the best AOT file runnable on the host CPU
+    bool SelectFatAOTEntry(const uint8_t* buf, uint32_t len, uint32_t& outOffset, uint32_t& outSize, uint32_t& outFlags) {
+        uint32_t version, entryCount;
+        memcpy(&version, buf + 4, sizeof(version));
+        memcpy(&entryCount, buf + 8, sizeof(entryCount));
+        uint32_t headerSize = version == 1 ? FAT_AOT_V1_HEADER_SIZE : FAT_AOT_HEADER_SIZE;
+        if ((version != 1 && version != FAT_AOT_VERSION) || len < headerSize || entryCount > (len - headerSize) / FAT_AOT_ENTRY_SIZE) {
+            snprintf(gLastErrorStr, sizeof(gLastErrorStr), "Invalid fat AOT file");
+            return false;
+        }
+        outFlags = 0;
+        if (version >= 2)
+            memcpy(&outFlags, buf + 12, sizeof(outFlags));
+        for (uint32_t i = 0; i < entryCount; i++) {
+            const uint8_t* pEntry = buf + headerSize + i * FAT_AOT_ENTRY_SIZE;
+            char profile[FAT_AOT_PROFILE_NAME_SIZE + 1] = {0};
+            memcpy(profile, pEntry, FAT_AOT_PROFILE_NAME_SIZE);
+            uint32_t offset, size;
+            memcpy(&offset, pEntry + FAT_AOT_PROFILE_NAME_SIZE, sizeof(offset));
+            memcpy(&size, pEntry + FAT_AOT_PROFILE_NAME_SIZE + 4, sizeof(size));
+            if (offset > len || size > len - offset) {
+                snprintf(gLastErrorStr, sizeof(gLastErrorStr), "Invalid fat AOT file");
+                return false;
+            }
+            if (CPUFeatures::IsAOTProfileSupported(profile)) {
+                outOffset = offset;
+                outSize = size;
+                return true;
+            }
+        }
+        snprintf(gLastErrorStr, sizeof(gLastErrorStr), "Host CPU doesn't support any AOT profile in the fat AOT file");
+        return false;
+    }
+
+    // Get the AOT image to load from the AOT file, which is the best entry of a fat AOT file or the whole file.
+    // Plain AOT files are compiled with bounds checks, the bound check mode of AOT files must match the runtime.
+    bool SelectAOTImage(const uint8_t* buf, uint32_t len, uint32_t& outOffset, uint32_t& outSize) {
+        uint32_t flags = 0;
+        if (IsFatAOT(buf, len)) {
+            if (!SelectFatAOTEntry(buf, len, outOffset, outSize, flags))
+                return false;
+        } else {
+            outOffset = 0;
+            outSize = len;
+        }
+#ifdef OS_ENABLE_HW_BOUND_CHECK
+        if (!(flags & FAT_AOT_FLAG_HW_BOUND_CHECK)) {
+            snprintf(gLastErrorStr, sizeof(gLastErrorStr), "AOT file is compiled with bounds checks, use wamr-ext-aot.py --hw-bound-check "
+                                                           "for wamr-ext built with WAMR_EXT_HW_BOUND_CHECK");
+            return false;
+        }
+#else
+        if (flags & FAT_AOT_FLAG_HW_BOUND_CHECK) {
+            snprintf(gLastErrorStr, sizeof(gLastErrorStr), "AOT file is compiled without bounds checks, which requires wamr-ext built "
+                                                           "with WAMR_EXT_HW_BOUND_CHECK");
+            return false;
+        }
+#endif
+        return true;
+    }
+
+    // The file is mapped private and writable since the loader may change the buffer, untouched pages are still shared
+    // across processes in the page cache. The file is kept open and returned by pOutFD if it's given.
+    int32_t MapModuleFile(const char* filePath, std::shared_ptr<uint8_t>& outBuf, uint32_t& outSize, int* pOutFD = nullptr) {
+#ifndef _WIN32
+        int fd = open(filePath, O_CLOEXEC | O_RDONLY);
+        if (fd == -1)
+            return errno;
+#else
+#error "mmap() file is not implemented for Win32"
+#endif
+        int32_t ret = 0;
+        do {
+#ifndef _WIN32
+            struct stat s = {0};
+            fstat(fd, &s);
+            uint32_t fileSize = s.st_size;
+            if (fileSize <= 0) {
+                ret = EINVAL;
+                break;
+            }
+            void* addr = mmap(nullptr, fileSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            if (addr == MAP_FAILED) {
+                ret = errno;
+                break;
+            }
+            outBuf.reset((uint8_t*)addr, [fileSize](uint8_t* p) {
+                munmap(p, fileSize);
+            });
+            outSize = fileSize;
+#endif
+        } while (false);
+#ifndef _WIN32
+        if (ret == 0 && pOutFD)
+            *pOutFD = fd;
+        else
+            close(fd);
+#endif
+        return ret;
+    }
+
+#define AOT_SECTION_TYPE_TEXT 2
+
+    // AOT file: magic(4B) | version(4B) | sections, section: type(4B) | size(4B) | body, each section starts at 4-byte aligned address
+    bool FindAOTTextSection(const uint8_t* pImage, uint32_t imageLen, const uint8_t*& outText, uint32_t& outTextSize) {
+        const uint8_t* p = pImage + 8;
+        const uint8_t* pEnd = pImage + imageLen;
+        while (true) {
+            p = (const uint8_t*)(((uintptr_t)p + 3) & ~(uintptr_t)3);
+            if (p > pEnd || pEnd - p < 8)
+                return false;
+            uint32_t sectionType, sectionSize;
+            memcpy(&sectionType, p, sizeof(sectionType));
+            memcpy(&sectionSize, p + 4, sizeof(sectionSize));
+            p += 8;
+            if (sectionSize > pEnd - p)
+                return false;
+            if (sectionType == AOT_SECTION_TYPE_TEXT) {
+                outText = p;
+                outTextSize = sectionSize;
+                return true;
+            }
+            p += sectionSize;
+        }
+    }
+
+    // Must be called after the XIP AOT image in the file mapping is loaded. WAMR executes the text of XIP files in place and
+    // never relocates it, references of the code go through tables allocated by the loader. Pages fully covered by the text
+    // are replaced by a read-only executable shared mapping of the file, so that they are shared with other processes in
+    // the page cache. Pages partly covered by the text stay private and are made read-only executable.
+    bool MapXIPTextShared(int fd, uint8_t* pFileBuf, uint32_t imageOffset, uint32_t imageLen) {
+#ifndef _WIN32
+        const uint8_t* pText = nullptr;
+        uint32_t textSize = 0;
+        if (!FindAOTTextSection(pFileBuf + imageOffset, imageLen, pText, textSize)) {
+            snprintf(gLastErrorStr, sizeof(gLastErrorStr), "Cannot find text section of the XIP AOT file");
+            return false;
+        }
+        if (textSize == 0)
+            return true;
+        static const uintptr_t pageSize = sysconf(_SC_PAGESIZE);
+        uintptr_t fileBase = (uintptr_t)pFileBuf;
+        uintptr_t textBegin = (uintptr_t)pText;
+        uintptr_t textEnd = textBegin + textSize;
+        uintptr_t pageBegin = textBegin & ~(pageSize - 1);
+        uintptr_t pageEnd = (textEnd + pageSize - 1) & ~(pageSize - 1);
+        uintptr_t sharedBegin = (textBegin + pageSize - 1) & ~(pageSize - 1);
+        uintptr_t sharedEnd = textEnd & ~(pageSize - 1);
+        bool bShared = false;
+        if (sharedBegin < sharedEnd) {
+            size_t sharedLen = sharedEnd - sharedBegin;
+            void* pShared = mmap(nullptr, sharedLen, PROT_READ | PROT_EXEC, MAP_SHARED, fd, sharedBegin - fileBase);
+            if (pShared != MAP_FAILED) {
+                // Keep the private pages if the loader has changed them
+                bShared = memcmp(pShared, (void*)sharedBegin, sharedLen) == 0;
+                munmap(pShared, sharedLen);
+                if (bShared)
+                    bShared = mmap((void*)sharedBegin, sharedLen, PROT_READ | PROT_EXEC, MAP_SHARED | MAP_FIXED, fd, sharedBegin - fileBase) != MAP_FAILED;
+            }
+        }
+        bool bProtected;
+        if (bShared) {
+            bProtected = (pageBegin == sharedBegin || mprotect((void*)pageBegin, sharedBegin - pageBegin, PROT_READ | PROT_EXEC) == 0) &&
+                         (pageEnd == sharedEnd || mprotect((void*)sharedEnd, pageEnd - sharedEnd, PROT_READ | PROT_EXEC) == 0);
+        } else {
+            bProtected = mprotect((void*)pageBegin, pageEnd - pageBegin, PROT_READ | PROT_EXEC) == 0;
+        }
+        if (!bProtected) {
+            snprintf(gLastErrorStr, sizeof(gLastErrorStr), "Failed to map text of the XIP AOT file executable: %s", strerror(errno));
+            return false;
+        }
+        return true;
+#else
+#error "Mapping XIP text is not implemented for Win32"
+#endif
+    }
+
+    // Load the AOT image at imageOffset of the module file, return nullptr on failure.
+    // fd is the module file, which is required for XIP AOT files loaded with WAMR_EXT_MODULE_LOAD_FLAG_XIP.
+    wasm_module_t LoadAOTImage(uint8_t* pFileBuf, uint32_t imageOffset, uint32_t imageLen, int fd, uint32_t loadFlags,
+                               char* errorBuf, uint32_t errorBufSize) {
+        uint8_t* pImage = pFileBuf + imageOffset;
+        bool bXIP = fd != -1 && (loadFlags & WAMR_EXT_MODULE_LOAD_FLAG_XIP) && wasm_runtime_is_xip_file(pImage, imageLen);
+        auto* wasmModule = wasm_runtime_load(pImage, imageLen, errorBuf, errorBufSize);
+        if (wasmModule && bXIP && !MapXIPTextShared(fd, pFileBuf, imageOffset, imageLen)) {
+            snprintf(errorBuf, errorBufSize, "%s", gLastErrorStr);
+            wasm_runtime_unload(wasmModule);
+            return nullptr;
+        }
+        return wasmModule;
+    }
+
+#ifdef OS_ENABLE_HW_BOUND_CHECK
+// AOT code without bounds checks must not be run by runtimes without HW bound check
+#define AOT_CACHE_VARIANT_SUFFIX "-hwbc"
+#else
+#define AOT_CACHE_VARIANT_SUFFIX ""
+#endif
+
+    // Must be called with gWasmLock held. The name is the only link between the bytecode and the native code run in its place,
+    // so it's named by the SHA-256 digest
+    std::filesystem::path GetCachedAOTFilePath(const SHA256::Digest& contentDigest) {
+        const char* verStr = nullptr;
+        wamr_ext_version(&verStr, nullptr);
+        char fileName[256];
+        snprintf(fileName, sizeof(fileName), "%s-%s%s-%s.aot", SHA256::ToHex(contentDigest).c_str(), WAMR_EXT_AOT_TARGET, AOT_CACHE_VARIANT_SUFFIX, verStr);
+        return gAOTCacheDir / fileName;
+    }
+
+    // Must be called with gWasmLock held, return nullptr if there is no usable AOT file in the cache dir
+    std::shared_ptr<WamrExtModuleCode> LoadCachedAOTCode(const SHA256::Digest& contentDigest, uint32_t loadFlags) {
+        if (gAOTCacheDir.empty())
+            return nullptr;
+        std::shared_ptr<uint8_t> pFileBuf;
+        uint32_t fileSize = 0;
+        int fd = -1;
+        if (MapModuleFile(GetCachedAOTFilePath(contentDigest).string().c_str(), pFileBuf, fileSize, &fd) != 0)
+            return nullptr;
+        uint32_t loadOffset = 0;
+        uint32_t loadLen = fileSize;
+        wasm_module_t wasmModule = nullptr;
+        char errorBuf[128];
+        if (SelectAOTImage(pFileBuf.get(), fileSize, loadOffset, loadLen))
+            wasmModule = LoadAOTImage(pFileBuf.get(), loadOffset, loadLen, fd, loadFlags, errorBuf, sizeof(errorBuf));
+        close(fd);
+        if (!wasmModule)
+            return nullptr;
+        return std::make_shared<WamrExtModuleCode>(pFileBuf, fileSize, wasmModule, true);
+    }
+
+    // Must be called with gWasmLock held, write symbols of AOT functions to the perf map if enabled.
+    // Function names are taken from the name section kept in the AOT file, then exports.
+    void WritePerfMapSymbols(WamrExtModuleBody* pBody) {
+        auto* pCode = pBody->pCode.get();
+        if (!gbPerfMapEnabled || !pCode->bAOT || pCode->bPerfMapWritten)
+            return;
+        pCode->bPerfMapWritten = true;
+        auto* pAOTModule = (AOTModule*)pCode->wasmModule;
+        if (pAOTModule->module_type != Wasm_Module_AoT || pAOTModule->func_count == 0)
+            return;
+        auto funcNames = GetWasmFuncNames(pCode->wasmModule);
+        // Function sizes are not kept, each function is assumed to end where the next one begins
+        std::vector<std::pair<uintptr_t, uint32_t>> funcAddrs;
+        for (uint32_t i = 0; i < pAOTModule->func_count; i++)
+            funcAddrs.emplace_back((uintptr_t)pAOTModule->func_ptrs[i], pAOTModule->import_func_count + i);
+        std::sort(funcAddrs.begin(), funcAddrs.end());
+        uintptr_t codeEnd = (uintptr_t)pAOTModule->code + pAOTModule->code_size;
+        std::vector<PerfMap::Symbol> symbols;
+        for (size_t i = 0; i < funcAddrs.size(); i++) {
+            uintptr_t funcEnd = i + 1 < funcAddrs.size() ? funcAddrs[i + 1].first : codeEnd;
+            if (funcEnd <= funcAddrs[i].first)
+                continue;
+            auto it = funcNames.find(funcAddrs[i].second);
+            std::string funcName = it != funcNames.end() ? it->second : "func[" + std::to_string(funcAddrs[i].second) + "]";
+            symbols.push_back({funcAddrs[i].first, funcEnd - funcAddrs[i].first, "wasm!" + pBody->name + "!" + funcName});
+        }
+        PerfMap::AddSymbols(symbols);
+    }
+
+    // Must be called with gWasmLock held
+    std::shared_ptr<WamrExtModuleBody> FindCachedModuleBody(const SHA256::Digest& contentDigest) {
+        auto it = gModuleBodyCache.find(contentDigest);
+        return it != gModuleBodyCache.end() ? it->second.lock() : nullptr;
+    }
+
+    // pModuleBuf is the buffer owned by the module, if null buf will be copied when the module is not cached.
+    // moduleFD is the file mapped by pModuleBuf, or -1 if the module is not loaded from a file.
+    int32_t WamrExtModuleLoad(wamr_ext_module_t* module, const char* moduleName, const uint8_t* buf, uint32_t len,
+                              std::shared_ptr<uint8_t> pModuleBuf, int moduleFD, uint32_t loadFlags) {
+        // Content is shared across module names, so a digest resistant to collisions is required
+        SHA256::Digest contentDigest = SHA256::Hash(buf, len);
         std::lock_guard<std::mutex> _al(gWasmLock);
         int32_t err = WamrExtCheckNewModuleName(moduleName);
         if (err != 0)
             return err;
-        auto* wasmModule = wasm_runtime_load(pModuleBuf.get(), len, gLastErrorStr, sizeof(gLastErrorStr));
-        if (!wasmModule)
+        auto pBody = FindCachedModuleBody(contentDigest);
+        if (!pBody) {
+            static const uint8_t wasmMagic[] = {'\0', 'a', 's', 'm'};
+            bool bBytecode = len >= sizeof(wasmMagic) && memcmp(buf, wasmMagic, sizeof(wasmMagic)) == 0;
+            std::shared_ptr<WamrExtModuleCode> pCode;
+            // Prefer the AOT file compiled from the same wasm bytecode
+            if (bBytecode)
+                pCode = LoadCachedAOTCode(contentDigest, loadFlags);
+            if (!pCode) {
+                uint32_t loadOffset = 0;
+                uint32_t loadLen = len;
+                if (!bBytecode && !SelectAOTImage(buf, len, loadOffset, loadLen))
+                    return -1;
+                if (!pModuleBuf) {
+                    pModuleBuf.reset(new uint8_t[len], std::default_delete<uint8_t[]>());
+                    memcpy(pModuleBuf.get(), buf, len);
+                }
+                wasm_module_t wasmModule;
+                if (bBytecode)
+                    wasmModule = wasm_runtime_load(pModuleBuf.get(), len, gLastErrorStr, sizeof(gLastErrorStr));
+                else
+                    wasmModule = LoadAOTImage(pModuleBuf.get(), loadOffset, loadLen, moduleFD, loadFlags, gLastErrorStr, sizeof(gLastErrorStr));
+                if (!wasmModule)
+                    return -1;
+                pCode = std::make_shared<WamrExtModuleCode>(pModuleBuf, len, wasmModule, !bBytecode);
+            }
+            pBody = std::make_shared<WamrExtModuleBody>(contentDigest, moduleName, pCode);
+            WritePerfMapSymbols(pBody.get());
+            // Drop entries of unloaded bodies
+            for (auto it = gModuleBodyCache.begin(); it != gModuleBodyCache.end();) {
+                if (it->second.expired())
+                    it = gModuleBodyCache.erase(it);
+                else
+                    it++;
+            }
+            gModuleBodyCache[contentDigest] = pBody;
+        }
+        *module = new WamrExtModule(pBody, moduleName);
+        return 0;
+    }
+
+    // Must be called with execFuncLock held
+    int32_t WamrExtDumpPGOProfile(WamrExtInstance* pInst, const char* filePath) {
+#if WASM_ENABLE_STATIC_PGO != 0
+        uint32_t dataSize = wasm_runtime_get_pgo_prof_data_size(pInst->wasmMainInstance);
+        if (dataSize == 0) {
+            snprintf(gLastErrorStr, sizeof(gLastErrorStr), "No PGO profile data, main module %s is not compiled with instrumentation",
+                     pInst->pMainModule->moduleName.c_str());
             return -1;
-        do {
-            *module = new WamrExtModule(pModuleBuf, wasmModule, moduleName);
-            return 0;
-        } while (false);
-        wasm_runtime_unload(wasmModule);
+        }
+        std::unique_ptr<char[]> pData(new char[dataSize]);
+        dataSize = wasm_runtime_dump_pgo_prof_data_to_buf(pInst->wasmMainInstance, pData.get(), dataSize);
+        FILE* fp = fopen(filePath, "wb");
+        if (!fp)
+            return errno;
+        bool bWritten = fwrite(pData.get(), 1, dataSize, fp) == dataSize;
+        fclose(fp);
+        return bWritten ? 0 : EIO;
+#else
+        snprintf(gLastErrorStr, sizeof(gLastErrorStr), "wamr-ext is not built with WAMR_EXT_BUILD_STATIC_PGO");
         return -1;
+#endif
+    }
+
+    // Must be called with instanceLock held
+    void TerminateInstance(WamrExtInstance* pInst, const char* reason) {
+        if (pInst->state != WamrExtInstance::STATE_STARTED)
+            return;
+        WasiPthreadExt::TerminateAppThreads(pInst->pMainExecEnv, reason);
+        if (!pInst->terminateNotifier.Notify()) {
+            // Blocked host calls of the instance won't be interrupted, they exit only when their own waits end
+            fprintf(stderr, "wamr-ext: failed to notify termination of instance: %s\n", strerror(errno));
+        }
+        WasiChannelExt::WakeUpWaiters(pInst->wasiChannelManager);
+        ScheduleInstanceCheck(pInst);
+    }
+
+    // Must be called with execFuncLock held
+    int32_t WamrExtCallWasmFunc(WamrExtInstance* pInst, wasm_function_inst_t wasmFuncInst, uint32_t argc, uint32_t* argv) {
+        uint64_t execSeq = 0;
+        {
+            std::lock_guard<std::mutex> instAL(pInst->instanceLock);
+            if (pInst->state != WamrExtInstance::STATE_STARTED) {
+                snprintf(gLastErrorStr, sizeof(gLastErrorStr), "Instance not started");
+                return -1;
+            }
+            pInst->bExecuting = true;
+            execSeq = ++pInst->execSeq;
+        }
+        std::shared_ptr<TimerHandle> pTimeoutTimer;
+        if (pInst->config.execTimeout > 0) {
+            auto& instLoop = gInstanceLoopPool.GetLoopThread((uintptr_t)pInst);
+            pTimeoutTimer = instLoop.PostTimerTask([pWeakInst = pInst->weak_from_this(), execSeq]() {
+                auto pInst = pWeakInst.lock();
+                if (!pInst)
+                    return;
+                std::lock_guard<std::mutex> instAL(pInst->instanceLock);
+                if (pInst->bExecuting && pInst->execSeq == execSeq)
+                    TerminateInstance(pInst.get(), "execution timeout");
+            }, pInst->config.execTimeout, 0);
+        }
+        // The main exec env may be used by different threads, e.g. worker threads of asynchronous calls
+        EnsureWasmThreadEnv();
+        wasm_exec_env_set_thread_info(pInst->pMainExecEnv);
+        WasiPthreadExt::BeginCPUTimeAccounting(pInst->pMainExecEnv);
+        bool bCallSucceeded = wasm_runtime_call_wasm(pInst->pMainExecEnv, wasmFuncInst, argc, argv);
+        WasiPthreadExt::EndCPUTimeAccounting(pInst->pMainExecEnv);
+        if (pTimeoutTimer)
+            pTimeoutTimer->Cancel();
+        {
+            std::lock_guard<std::mutex> instAL(pInst->instanceLock);
+            pInst->bExecuting = false;
+        }
+        if (!bCallSucceeded) {
+            snprintf(gLastErrorStr, sizeof(gLastErrorStr), "%s", wasm_runtime_get_exception(pInst->wasmMainInstance));
+            ScheduleInstanceCheck(pInst);
+            return -1;
+        }
+        return 0;
+    }
+
+    static_assert(WAMR_EXT_VALUE_I32 == WASM_I32 && WAMR_EXT_VALUE_I64 == WASM_I64 &&
+                  WAMR_EXT_VALUE_F32 == WASM_F32 && WAMR_EXT_VALUE_F64 == WASM_F64);
+
+    uint32_t GetValueCellCount(const std::vector<wasm_valkind_t>& types) {
+        uint32_t cellCount = 0;
+        for (auto type : types)
+            cellCount += (type == WASM_I64 || type == WASM_F64) ? 2 : 1;
+        return cellCount;
+    }
+
+    // Must be called after the instance started
+    WamrExtFunc* WamrExtLookupFunc(WamrExtInstance* pInst, const char* funcName) {
+        auto* pModule = pInst->pMainModule;
+        {
+            std::lock_guard<std::mutex> _al(pModule->funcLock);
+            auto it = pModule->funcMap.find(funcName);
+            if (it != pModule->funcMap.end())
+                return it->second.get();
+        }
+        wasm_function_inst_t wasmFuncInst = wasm_runtime_lookup_function(pInst->wasmMainInstance, funcName, nullptr);
+        if (!wasmFuncInst) {
+            snprintf(gLastErrorStr, sizeof(gLastErrorStr), "Cannot find function %s() in main module %s", funcName, pModule->moduleName.c_str());
+            return nullptr;
+        }
+        auto pNewFunc = std::make_unique<WamrExtFunc>();
+        pNewFunc->pModule = pModule;
+        pNewFunc->name = funcName;
+        pNewFunc->paramTypes.resize(wasm_func_get_param_count(wasmFuncInst, pInst->wasmMainInstance));
+        pNewFunc->resultTypes.resize(wasm_func_get_result_count(wasmFuncInst, pInst->wasmMainInstance));
+        wasm_func_get_param_types(wasmFuncInst, pInst->wasmMainInstance, pNewFunc->paramTypes.data());
+        wasm_func_get_result_types(wasmFuncInst, pInst->wasmMainInstance, pNewFunc->resultTypes.data());
+        for (auto type : pNewFunc->paramTypes) {
+            if (type > WASM_F64) {
+                snprintf(gLastErrorStr, sizeof(gLastErrorStr), "Function %s() has unsupported parameter types", funcName);
+                return nullptr;
+            }
+        }
+        for (auto type : pNewFunc->resultTypes) {
+            if (type > WASM_F64) {
+                snprintf(gLastErrorStr, sizeof(gLastErrorStr), "Function %s() has unsupported result types", funcName);
+                return nullptr;
+            }
+        }
+        pNewFunc->paramCellCount = GetValueCellCount(pNewFunc->paramTypes);
+        pNewFunc->resultCellCount = GetValueCellCount(pNewFunc->resultTypes);
+        std::lock_guard<std::mutex> _al(pModule->funcLock);
+        auto& pFunc = pModule->funcMap[funcName];
+        if (!pFunc) {
+            pNewFunc->index = pModule->funcMap.size() - 1;
+            pFunc = std::move(pNewFunc);
+        }
+        return pFunc.get();
+    }
+
+    // Must be called with execFuncLock held, args and results have been checked by the caller
+    int32_t WamrExtCallFunc(WamrExtInstance* pInst, WamrExtFunc* pFunc, const WamrExtValue* args, WamrExtValue* results) {
+        assert(pInst->wasmMainInstance && pFunc->pModule == pInst->pMainModule);
+        auto& funcInstCache = pInst->funcInstCache;
+        if (pFunc->index >= funcInstCache.size())
+            funcInstCache.resize(pFunc->index + 1, nullptr);
+        if (!funcInstCache[pFunc->index])
+            funcInstCache[pFunc->index] = wasm_runtime_lookup_function(pInst->wasmMainInstance, pFunc->name.c_str(), nullptr);
+        wasm_function_inst_t wasmFuncInst = funcInstCache[pFunc->index];
+        assert(wasmFuncInst);
+        uint32_t* cells = (uint32_t*)alloca(sizeof(uint32_t) * std::max<uint32_t>(std::max(pFunc->paramCellCount, pFunc->resultCellCount), 1));
+        uint32_t cellIndex = 0;
+        for (uint32_t i = 0; i < pFunc->paramTypes.size(); i++) {
+            if (pFunc->paramTypes[i] == WASM_I64 || pFunc->paramTypes[i] == WASM_F64) {
+                memcpy(&cells[cellIndex], &args[i].of, sizeof(uint64_t));
+                cellIndex += 2;
+            } else {
+                memcpy(&cells[cellIndex], &args[i].of, sizeof(uint32_t));
+                cellIndex += 1;
+            }
+        }
+        int32_t err = WamrExtCallWasmFunc(pInst, wasmFuncInst, pFunc->paramCellCount, cells);
+        if (err != 0)
+            return err;
+        cellIndex = 0;
+        for (uint32_t i = 0; i < pFunc->resultTypes.size(); i++) {
+            results[i].kind = (WamrExtValueKind)pFunc->resultTypes[i];
+            if (pFunc->resultTypes[i] == WASM_I64 || pFunc->resultTypes[i] == WASM_F64) {
+                memcpy(&results[i].of, &cells[cellIndex], sizeof(uint64_t));
+                cellIndex += 2;
+            } else {
+                memcpy(&results[i].of, &cells[cellIndex], sizeof(uint32_t));
+                cellIndex += 1;
+            }
+        }
+        return 0;
+    }
+
+    int32_t WamrExtCheckFuncArgs(WamrExtFunc* pFunc, const WamrExtValue* args, uint32_t argc) {
+        if (argc != pFunc->paramTypes.size()) {
+            snprintf(gLastErrorStr, sizeof(gLastErrorStr), "Function %s() expects %u arguments but %u given",
+                     pFunc->name.c_str(), (uint32_t)pFunc->paramTypes.size(), argc);
+            return -1;
+        }
+        for (uint32_t i = 0; i < argc; i++) {
+            if (pFunc->paramTypes[i] != (wasm_valkind_t)args[i].kind) {
+                snprintf(gLastErrorStr, sizeof(gLastErrorStr), "Type of argument %u mismatches with function %s()", i, pFunc->name.c_str());
+                return -1;
+            }
+        }
+        return 0;
     }
 
     void RegisterExtSyscall(wasi::wamr_ext_syscall_id syscallID, const std::shared_ptr<ExtSyscallBase>& pSyscallImpl) {
+        pSyscallImpl->statsIndex = ExtSyscallStats::RegisterSyscall(syscallID);
         gExtSyscallMap[syscallID] = pSyscallImpl;
     }
 
@@ -108,62 +656,143 @@ namespace WAMR_EXT_NS {
             assert(false);
             return UVWASI_ENOSYS;
         }
-        return it->second->Invoke(pExecEnv, argc, argv);
+        WasiPthreadExt::UpdateCPUTimeUsage(pExecEnv);
+        if (!ExtSyscallStats::IsEnabled())
+            return it->second->Invoke(pExecEnv, argc, argv);
+        auto beginTime = std::chrono::steady_clock::now();
+        int32_t ret = it->second->Invoke(pExecEnv, argc, argv);
+        uint64_t latencyNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - beginTime).count();
+        auto* pWamrExtInst = (WamrExtInstance*)wasm_runtime_get_custom_data(get_module_inst(pExecEnv));
+        if (pWamrExtInst)
+            pWamrExtInst->syscallStats.Record(it->second->statsIndex, latencyNs, ret != 0);
+        return ret;
     }
 
-    void LoopCheckInstanceRoutine() {
-        std::unique_lock<std::mutex> globalWasmAL(gWasmLock);
-        if (gAllInstanceList.empty())
-            return;
-        auto instanceListIt = gAllInstanceList.begin();
-        globalWasmAL.unlock();
-        std::shared_ptr<WamrExtInstance> pInst;
-        while (true) {
-            pInst = *instanceListIt;
-            bool bInstDestroyed = false;
+    void ExecAsyncCall(WamrExtInstance* pInst, const WamrExtAsyncCall& call) {
+        std::vector<WamrExtValue> results;
+        int32_t err = -1;
+        {
+            std::lock_guard<std::mutex> _al(pInst->execFuncLock);
+            WamrExtFunc* pFunc = nullptr;
+            if (!pInst->wasmMainInstance)
+                snprintf(gLastErrorStr, sizeof(gLastErrorStr), "Instance not started or destroyed");
+            else if ((pFunc = WamrExtLookupFunc(pInst, call.funcName.c_str())) &&
+                     WamrExtCheckFuncArgs(pFunc, call.args.data(), call.args.size()) == 0) {
+                results.resize(pFunc->resultTypes.size());
+                err = WamrExtCallFunc(pInst, pFunc, call.args.data(), results.data());
+                if (err != 0)
+                    results.clear();
+            }
+        }
+        call.completionCB.func(err, results.data(), results.size(), call.completionCB.user_data);
+    }
+
+    // Run in a worker thread. Only one worker drains the calls of an instance, and it yields to calls of other instances
+    // after a batch, so that one busy instance cannot occupy all workers.
+    void DrainAsyncCalls(const std::shared_ptr<WamrExtInstance>& pInst) {
+        const uint32_t ASYNC_CALL_BATCH_SIZE = 16;
+        for (uint32_t i = 0; i < ASYNC_CALL_BATCH_SIZE; i++) {
+            WamrExtAsyncCall call;
             {
-                std::unique_lock<std::mutex> instAL(pInst->instanceLock);
-                switch (pInst->state) {
-                    case WamrExtInstance::STATE_STARTED: {
-                        const char* exceptionStr = wasm_runtime_get_exception(pInst->wasmMainInstance);
-                        if (exceptionStr && exceptionStr[0]) {
-                            WamrExtExceptionInfo exceptionInfo;
-                            exceptionInfo.errorCode = -1;
-                            exceptionInfo.errorStr = exceptionStr;
-                            auto exceptionCB = pInst->config.exceptionCB;
-                            pInst->state = WamrExtInstance::STATE_ENDED;
-                            if (exceptionCB.func) {
-                                instAL.unlock();
-                                exceptionCB.func(pInst->pUserCallbackPointer, &exceptionInfo, exceptionCB.user_data);
-                                instAL.lock();
-                            }
-                        }
-                        break;
-                    }
-                    case WamrExtInstance::STATE_DESTROYED: {
-                        bInstDestroyed = true;
-                        break;
+                std::lock_guard<std::mutex> _al(pInst->asyncCallLock);
+                if (pInst->asyncCallQueue.empty()) {
+                    pInst->bAsyncCallDraining = false;
+                    return;
+                }
+                call = std::move(pInst->asyncCallQueue.front());
+                pInst->asyncCallQueue.pop_front();
+            }
+            ExecAsyncCall(pInst.get(), call);
+        }
+        std::lock_guard<std::mutex> _al(pInst->asyncCallLock);
+        if (pInst->asyncCallQueue.empty() || !gCallWorkerPool.PostTask([pInst]() { DrainAsyncCalls(pInst); }))
+            pInst->bAsyncCallDraining = false;
+    }
+
+    // Run in the loop thread of the instance, report exception of the instance in gCallbackLoop.
+    // Return true if the instance has been destroyed and can be released.
+    bool CheckInstance(const std::shared_ptr<WamrExtInstance>& pInst) {
+        std::lock_guard<std::mutex> instAL(pInst->instanceLock);
+        switch (pInst->state) {
+            case WamrExtInstance::STATE_STARTED: {
+                const char* exceptionStr = wasm_runtime_get_exception(pInst->wasmMainInstance);
+                if (exceptionStr && exceptionStr[0]) {
+                    auto pExceptionInfo = std::make_shared<WamrExtExceptionInfo>();
+                    pExceptionInfo->errorCode = -1;
+                    pExceptionInfo->errorStr = exceptionStr;
+                    auto exceptionCB = pInst->config.exceptionCB;
+                    pInst->state = WamrExtInstance::STATE_ENDED;
+                    if (pInst->pCheckTimer)
+                        pInst->pCheckTimer->Cancel();
+                    if (exceptionCB.func) {
+                        gCallbackLoop.PostTask([pInst, pExceptionInfo, exceptionCB]() {
+                            exceptionCB.func(pInst->pUserCallbackPointer, pExceptionInfo.get(), exceptionCB.user_data);
+                        });
                     }
                 }
+                return false;
             }
-            globalWasmAL.lock();
-            if (bInstDestroyed)
-                instanceListIt = gAllInstanceList.erase(instanceListIt);
-            else
-                instanceListIt = std::next(instanceListIt);
-            if (instanceListIt == gAllInstanceList.end()) {
-                globalWasmAL.unlock();
-                break;
+            case WamrExtInstance::STATE_DESTROYED:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    void ScheduleInstanceCheck(WamrExtInstance* pInst) {
+        if (pInst->bCheckScheduled.exchange(true, std::memory_order_acq_rel))
+            return;
+        gInstanceLoopPool.GetLoopThread((uintptr_t)pInst).PostTask([pWeakInst = pInst->weak_from_this()]() {
+            auto pInst = pWeakInst.lock();
+            if (!pInst)
+                return;
+            pInst->bCheckScheduled.store(false, std::memory_order_release);
+            if (CheckInstance(pInst))
+                gAllInstances.Remove(pInst.get());
+        });
+    }
+
+    // Run periodically in the loop thread of the instance while it is started
+    void LoopCheckInstanceRoutine(const std::weak_ptr<WamrExtInstance>& pWeakInst) {
+        auto pInst = pWeakInst.lock();
+        if (!pInst)
+            return;
+        if (pInst->config.maxCPUTime > 0) {
+            std::lock_guard<std::mutex> instAL(pInst->instanceLock);
+            if (pInst->state == WamrExtInstance::STATE_STARTED) {
+                // Compute-bound threads may never call into the host, so sample their CPU clocks here
+                WasiPthreadExt::SampleCPUTimeUsage(&pInst->wasiPthreadManager);
+                if (pInst->wasiPthreadManager.GetCPUTimeUsageNs() / 1000 > pInst->config.maxCPUTime)
+                    TerminateInstance(pInst.get(), "cpu time limit exceeded");
             }
-            globalWasmAL.unlock();
         }
+        // Fallback of the scheduled checks, in case of exceptions raised inside WAMR without notifying us
+        if (CheckInstance(pInst))
+            gAllInstances.Remove(pInst.get());
     }
 }
 
 int32_t wamr_ext_init() {
+    const char* requiredCPUProfile = nullptr;
+    if (!WAMR_EXT_NS::CPUFeatures::IsBuildTargetSupported(requiredCPUProfile)) {
+        snprintf(WAMR_EXT_NS::gLastErrorStr, sizeof(WAMR_EXT_NS::gLastErrorStr), "Host CPU doesn't support %s which wamr-ext is built for",
+                 requiredCPUProfile);
+        return -1;
+    }
+    RuntimeInitArgs initArgs;
+    memset(&initArgs, 0, sizeof(initArgs));
+    initArgs.mem_alloc_type = Alloc_With_System_Allocator;
     // We will allocate stack from app heap area instead of app stack area for new app threads
-    wasm_runtime_set_max_thread_num(1);
-    if (!wasm_runtime_init())
+    initArgs.max_thread_num = 1;
+#ifdef WAMR_EXT_MULTI_TIER_JIT
+    // Bytecode modules start running by fast JIT, functions compiled lazily on their first calls. LLVM JIT compiles
+    // them again in background threads, calls made after that are switched to the LLVM JIT code, including calls of
+    // running instances.
+    initArgs.running_mode = Mode_Multi_Tier_JIT;
+    initArgs.llvm_jit_opt_level = 3;
+    initArgs.llvm_jit_size_level = 3;
+#endif
+    if (!wasm_runtime_full_init(&initArgs))
         return -1;
     WAMR_EXT_NS::gExtSyscallMap.reserve(100);
     static NativeSymbol nativeSymbols[] = {
@@ -176,58 +805,64 @@ int32_t wamr_ext_init() {
     WAMR_EXT_NS::WasiSocketExt::Init();
     WAMR_EXT_NS::WasiProcessExt::Init();
     WAMR_EXT_NS::WasiMiscExt::Init();
-    WAMR_EXT_NS::gLoopThread.Start();
-    WAMR_EXT_NS::gLoopThread.PostTimerTask(WAMR_EXT_NS::LoopCheckInstanceRoutine, 0, 100);
+    WAMR_EXT_NS::WasiChannelExt::Init();
+    WAMR_EXT_NS::gInstanceLoopPool.Start();
+    WAMR_EXT_NS::gCallbackLoop.Start();
+    WAMR_EXT_NS::gCallWorkerPool.Start();
     return 0;
 }
 
-int32_t wamr_ext_module_load_by_file(wamr_ext_module_t* module, const char* module_name, const char* file_path) {
-    int32_t err = WAMR_EXT_NS::WamrExtCheckNewModuleName(module_name);
-    if (err != 0)
-        return err;
-#ifndef _WIN32
-    int fd = open(file_path, O_CLOEXEC | O_RDONLY);
-    if (fd == -1)
-        return errno;
-#else
-#error "mmap() file is not implemented for Win32"
-#endif
-    int32_t ret = 0;
-    do {
-#ifndef _WIN32
-        struct stat s = {0};
-        fstat(fd, &s);
-        uint32_t fileSize = s.st_size;
-        if (fileSize <= 0) {
-            ret = EINVAL;
+int32_t wamr_ext_set_global_opt(enum WamrExtGlobalOpt opt, const void* value) {
+    if (!value)
+        return EINVAL;
+    std::lock_guard<std::mutex> _al(WAMR_EXT_NS::gWasmLock);
+    switch (opt) {
+        case WAMR_EXT_GLOBAL_OPT_AOT_CACHE_DIR: {
+            WAMR_EXT_NS::gAOTCacheDir = (const char*)value;
             break;
         }
-        void* addr = mmap(nullptr, fileSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
-        if (addr == MAP_FAILED) {
-            ret = errno;
+        case WAMR_EXT_GLOBAL_OPT_SYSCALL_STATS: {
+            WAMR_EXT_NS::ExtSyscallStats::SetEnabled(*((uint32_t*)value) != 0);
             break;
         }
-        close(fd);
-        fd = -1;
-        std::shared_ptr<uint8_t> pFileBuf((uint8_t*)addr, [fileSize](uint8_t* p) {
-            munmap(p, fileSize);
-        });
-#endif
-        ret = WAMR_EXT_NS::WamrExtModuleLoad(module, module_name, pFileBuf, fileSize);
-    } while (false);
-#ifndef _WIN32
-    if (fd != -1)
-        close(fd);
-#endif
-    return ret;
+        case WAMR_EXT_GLOBAL_OPT_PERF_MAP: {
+            WAMR_EXT_NS::gbPerfMapEnabled = *((uint32_t*)value) != 0;
+            // Write symbols of modules loaded before
+            for (const auto& it : WAMR_EXT_NS::gModuleBodyCache) {
+                if (auto pBody = it.second.lock())
+                    WAMR_EXT_NS::WritePerfMapSymbols(pBody.get());
+            }
+            break;
+        }
+        default:
+            return EINVAL;
+    }
+    return 0;
+}
+
+int32_t wamr_ext_module_load_by_file(wamr_ext_module_t* module, const char* module_name, const char* file_path) {
+    return wamr_ext_module_load_by_file_ex(module, module_name, file_path, 0);
+}
+
+int32_t wamr_ext_module_load_by_file_ex(wamr_ext_module_t* module, const char* module_name, const char* file_path, uint32_t flags) {
+    int32_t err = WAMR_EXT_NS::WamrExtCheckNewModuleName(module_name);
+    if (err != 0)
+        return err;
+    std::shared_ptr<uint8_t> pFileBuf;
+    uint32_t fileSize = 0;
+    int fd = -1;
+    if ((err = WAMR_EXT_NS::MapModuleFile(file_path, pFileBuf, fileSize, &fd)) != 0)
+        return err;
+    err = WAMR_EXT_NS::WamrExtModuleLoad(module, module_name, pFileBuf.get(), fileSize, pFileBuf, fd, flags);
+    close(fd);
+    return err;
 }
 
 int32_t wamr_ext_module_load_by_buffer(wamr_ext_module_t* module, const char* module_name, const uint8_t* buf, uint32_t len) {
     if (!buf || len <= 0 || !module)
         return EINVAL;
-    std::shared_ptr<uint8_t> pNewBuf(new uint8_t[len], std::default_delete<uint8_t[]>());
-    memcpy(pNewBuf.get(), buf, len);
-    return WAMR_EXT_NS::WamrExtModuleLoad(module, module_name, pNewBuf, len);
+    // The buffer is copied only if the same content has not been loaded
+    return WAMR_EXT_NS::WamrExtModuleLoad(module, module_name, buf, len, nullptr, -1, 0);
 }
 
 int32_t wamr_ext_module_set_inst_default_opt(wamr_ext_module_t* module, enum WamrExtInstanceOpt opt, const void* value) {
@@ -239,9 +874,9 @@ int32_t wamr_ext_module_set_inst_default_opt(wamr_ext_module_t* module, enum Wam
 int32_t wamr_ext_instance_create(wamr_ext_module_t* module, wamr_ext_instance_t* inst) {
     if (!module || !(*module))
         return EINVAL;
-    *inst = new WamrExtInstance(*module, inst);
-    std::lock_guard<std::mutex> _al(WAMR_EXT_NS::gWasmLock);
-    WAMR_EXT_NS::gAllInstanceList.emplace_back(*inst);
+    auto pInst = std::make_shared<WamrExtInstance>(*module, inst);
+    *inst = pInst.get();
+    WAMR_EXT_NS::gAllInstances.Insert(pInst);
     return 0;
 }
 
@@ -299,13 +934,14 @@ int32_t wamr_ext_instance_start(wamr_ext_instance_t* inst) {
 #endif
 
         std::lock_guard<std::mutex> wasmAL(WAMR_EXT_NS::gWasmLock);
-        wasm_runtime_set_wasi_args_ex(pInst->pMainModule->wasmModule, tempPreOpenHostDirs.data(), tempPreOpenHostDirs.size(),
+        pInst->pMainModuleCode = pInst->pMainModule->pBody->pCode;
+        wasm_runtime_set_wasi_args_ex(pInst->pMainModuleCode->wasmModule, tempPreOpenHostDirs.data(), tempPreOpenHostDirs.size(),
                                       tempPreOpenMapDirs.data(), tempPreOpenMapDirs.size(),
                                       tempEnvVars.data(), tempEnvVars.size(),
                                       const_cast<char**>(tempArgv.data()), tempArgv.size(),
                                       newStdinFD, newStdOutFD, newStdErrFD);
         // Set app heap size to WASM_PAGE_SIZE here, it will be enlarged later
-        pInst->wasmMainInstance = wasm_runtime_instantiate(pInst->pMainModule->wasmModule, WASM_INST_OPER_STACK_SIZE, WASM_PAGE_SIZE,
+        pInst->wasmMainInstance = wasm_runtime_instantiate(pInst->pMainModuleCode->wasmModule, WASM_INST_OPER_STACK_SIZE, WASM_PAGE_SIZE,
                                                            WAMR_EXT_NS::gLastErrorStr, sizeof(WAMR_EXT_NS::gLastErrorStr));
         if (!pInst->wasmMainInstance)
             return -1;
@@ -324,8 +960,15 @@ int32_t wamr_ext_instance_start(wamr_ext_instance_t* inst) {
             mem_allocator_destroy(pMemory->heap_handle);
             auto pHeapHandler = pMemory->heap_handle;
             pMemory->heap_handle = nullptr;
+#ifdef OS_ENABLE_HW_BOUND_CHECK
+            // The linear memory is at the start of a reserved 8GB region and out of bounds accesses are trapped by signals,
+            // commit pages up to maxMemory but don't touch them to reduce process RSS
+            uint8_t* pNewMem = os_mprotect(pMemory->memory_data, pInst->config.maxMemory, MMAP_PROT_READ | MMAP_PROT_WRITE) == 0 ?
+                               pMemory->memory_data : nullptr;
+#else
             // Allocate new memory but don't touch it to reduce process RSS
             uint8_t* pNewMem = (uint8_t*)wasm_runtime_realloc(pMemory->memory_data, pInst->config.maxMemory);
+#endif
             if (!pNewMem) {
                 snprintf(WAMR_EXT_NS::gLastErrorStr, sizeof(WAMR_EXT_NS::gLastErrorStr), "Cannot allocate %uB memory for instance\n", pInst->config.maxMemory);
                 std::lock_guard<std::mutex> instAL(pInst->instanceLock);
@@ -356,6 +999,15 @@ int32_t wamr_ext_instance_start(wamr_ext_instance_t* inst) {
         }
         wasm_runtime_set_custom_data(get_module_inst(pInst->pMainExecEnv), pInst);
         WAMR_EXT_NS::WasiPthreadExt::InitAppMainThreadInfo(pInst->pMainExecEnv);
+        if (pInst->config.ioBufferSize > 0) {
+            void* _p;
+            pInst->ioBufferAppOffset = wasm_runtime_module_malloc(pInst->wasmMainInstance, pInst->config.ioBufferSize, &_p);
+            if (pInst->ioBufferAppOffset == 0) {
+                snprintf(WAMR_EXT_NS::gLastErrorStr, sizeof(WAMR_EXT_NS::gLastErrorStr), "Failed to allocate IO buffer of %u bytes", pInst->config.ioBufferSize);
+                return -1;
+            }
+            pInst->pIOBufferAllocator = std::make_unique<WAMR_EXT_NS::RingBufferAllocator>(pInst->config.ioBufferSize);
+        }
     }
     wasm_function_inst_t wasmFuncInst = wasm_runtime_lookup_function(pInst->wasmMainInstance, "_initialize", "()");
     if (!wasmFuncInst) {
@@ -364,7 +1016,11 @@ int32_t wamr_ext_instance_start(wamr_ext_instance_t* inst) {
         pInst->state = WamrExtInstance::STATE_ENDED;
         return -1;
     }
-    if (!wasm_runtime_call_wasm_a(pInst->pMainExecEnv, wasmFuncInst, 0, nullptr, 0, nullptr)) {
+    WAMR_EXT_NS::EnsureWasmThreadEnv();
+    WAMR_EXT_NS::WasiPthreadExt::BeginCPUTimeAccounting(pInst->pMainExecEnv);
+    bool bCallSucceeded = wasm_runtime_call_wasm_a(pInst->pMainExecEnv, wasmFuncInst, 0, nullptr, 0, nullptr);
+    WAMR_EXT_NS::WasiPthreadExt::EndCPUTimeAccounting(pInst->pMainExecEnv);
+    if (!bCallSucceeded) {
         snprintf(WAMR_EXT_NS::gLastErrorStr, sizeof(WAMR_EXT_NS::gLastErrorStr), "%s", wasm_runtime_get_exception(pInst->wasmMainInstance));
         std::lock_guard<std::mutex> instAL(pInst->instanceLock);
         pInst->state = WamrExtInstance::STATE_ENDED;
@@ -373,6 +1029,12 @@ int32_t wamr_ext_instance_start(wamr_ext_instance_t* inst) {
 
     std::lock_guard<std::mutex> instAL(pInst->instanceLock);
     pInst->state = WamrExtInstance::STATE_STARTED;
+    // CPU time budget is checked more often than exceptions
+    uint64_t checkInterval = pInst->config.maxCPUTime > 0 ? 100 : 1000;
+    auto& instLoop = WAMR_EXT_NS::gInstanceLoopPool.GetLoopThread((uintptr_t)pInst);
+    pInst->pCheckTimer = instLoop.PostTimerTask([pWeakInst = pInst->weak_from_this()]() {
+        WAMR_EXT_NS::LoopCheckInstanceRoutine(pWeakInst);
+    }, checkInterval, checkInterval);
     return 0;
 }
 
@@ -381,34 +1043,82 @@ WAMR_EXT_API int32_t wamr_ext_instance_exec_main_func(wamr_ext_instance_t* inst,
         return EINVAL;
     auto pInst = *inst;
     std::lock_guard<std::mutex> _al(pInst->execFuncLock);
-    {
-        std::lock_guard<std::mutex> instAL(pInst->instanceLock);
-        if (pInst->state != WamrExtInstance::STATE_STARTED) {
-            snprintf(WAMR_EXT_NS::gLastErrorStr, sizeof(WAMR_EXT_NS::gLastErrorStr), "Instance not started");
-            return -1;
-        }
-    }
-    wasm_function_inst_t wasmFuncInst = wasm_runtime_lookup_function(pInst->wasmMainInstance, "__main_void", "()i");
-    if (!wasmFuncInst) {
-        snprintf(WAMR_EXT_NS::gLastErrorStr, sizeof(WAMR_EXT_NS::gLastErrorStr), "Cannot find function __main_void() in main module %s\n", pInst->pMainModule->moduleName.c_str());
+    if (!pInst->wasmMainInstance) {
+        snprintf(WAMR_EXT_NS::gLastErrorStr, sizeof(WAMR_EXT_NS::gLastErrorStr), "Instance not started");
         return -1;
     }
-    wasm_val_t wasmRetVal;
-    if (!wasm_runtime_call_wasm_a(pInst->pMainExecEnv, wasmFuncInst, 1, &wasmRetVal, 0, nullptr)) {
-        snprintf(WAMR_EXT_NS::gLastErrorStr, sizeof(WAMR_EXT_NS::gLastErrorStr), "%s", wasm_runtime_get_exception(pInst->wasmMainInstance));
+    auto* pFunc = WAMR_EXT_NS::WamrExtLookupFunc(pInst, "__main_void");
+    if (!pFunc || !pFunc->paramTypes.empty() || pFunc->resultTypes.size() != 1 || pFunc->resultTypes[0] != WASM_I32) {
+        snprintf(WAMR_EXT_NS::gLastErrorStr, sizeof(WAMR_EXT_NS::gLastErrorStr), "Cannot find function __main_void() in main module %s\n", pInst->pMainModule->moduleName.c_str());
         return -1;
     }
+    WamrExtValue wasmRetVal;
+    int32_t err = WAMR_EXT_NS::WamrExtCallFunc(pInst, pFunc, nullptr, &wasmRetVal);
+    if (err != 0)
+        return err;
     if (ret_value)
         *ret_value = wasmRetVal.of.i32;
     return 0;
 }
 
+int32_t wamr_ext_instance_lookup_func(wamr_ext_instance_t* inst, const char* func_name, wamr_ext_func_t* func) {
+    if (!inst || !(*inst) || !func_name || !func)
+        return EINVAL;
+    auto pInst = *inst;
+    std::lock_guard<std::mutex> _al(pInst->execFuncLock);
+    if (!pInst->wasmMainInstance) {
+        snprintf(WAMR_EXT_NS::gLastErrorStr, sizeof(WAMR_EXT_NS::gLastErrorStr), "Instance not started");
+        return -1;
+    }
+    *func = WAMR_EXT_NS::WamrExtLookupFunc(pInst, func_name);
+    return *func ? 0 : -1;
+}
+
+int32_t wamr_ext_instance_call_func(wamr_ext_instance_t* inst, wamr_ext_func_t* func, const WamrExtValue* argv, uint32_t argc,
+                                    WamrExtValue* results, uint32_t result_count) {
+    if (!inst || !(*inst) || !func || !(*func) || (argc > 0 && !argv) || (result_count > 0 && !results))
+        return EINVAL;
+    auto pInst = *inst;
+    auto pFunc = *func;
+    if (pFunc->pModule != pInst->pMainModule || result_count < pFunc->resultTypes.size())
+        return EINVAL;
+    int32_t err = WAMR_EXT_NS::WamrExtCheckFuncArgs(pFunc, argv, argc);
+    if (err != 0)
+        return err;
+    std::lock_guard<std::mutex> _al(pInst->execFuncLock);
+    if (!pInst->wasmMainInstance) {
+        snprintf(WAMR_EXT_NS::gLastErrorStr, sizeof(WAMR_EXT_NS::gLastErrorStr), "Instance not started");
+        return -1;
+    }
+    return WAMR_EXT_NS::WamrExtCallFunc(pInst, pFunc, argv, results);
+}
+
+int32_t wamr_ext_instance_call_async(wamr_ext_instance_t* inst, const char* func_name, const WamrExtValue* args,
+                                     uint32_t argc, const WamrExtCallCompletionCB* completion_cb) {
+    if (!inst || !(*inst) || !func_name || (argc > 0 && !args) || !completion_cb || !completion_cb->func)
+        return EINVAL;
+    auto pInst = *inst;
+    std::lock_guard<std::mutex> _al(pInst->asyncCallLock);
+    pInst->asyncCallQueue.push_back({func_name, std::vector<WamrExtValue>(args, args + argc), *completion_cb});
+    if (pInst->bAsyncCallDraining)
+        return 0;
+    if (!WAMR_EXT_NS::gCallWorkerPool.PostTask([pInst = pInst->shared_from_this()]() { WAMR_EXT_NS::DrainAsyncCalls(pInst); })) {
+        pInst->asyncCallQueue.pop_back();
+        snprintf(WAMR_EXT_NS::gLastErrorStr, sizeof(WAMR_EXT_NS::gLastErrorStr), "Worker threads not started");
+        return -1;
+    }
+    pInst->bAsyncCallDraining = true;
+    return 0;
+}
+
 WAMR_EXT_API int32_t wamr_ext_instance_destroy(wamr_ext_instance_t* inst) {
     if (!inst || !(*inst))
         return EINVAL;
     auto pInst = *inst;
+    // The loop thread may release the instance as soon as it is marked destroyed, keep it alive until both locks are released
+    auto pHold = pInst->shared_from_this();
     bool bRunDtor = false;
-    std::lock_guard<std::mutex> _al(pInst->execFuncLock);
+    std::unique_lock<std::mutex> _al(pInst->execFuncLock);
     {
         std::lock_guard<std::mutex> instAL(pInst->instanceLock);
         if (pInst->state >= WamrExtInstance::STATE_DESTROYING) {
@@ -423,9 +1133,15 @@ WAMR_EXT_API int32_t wamr_ext_instance_destroy(wamr_ext_instance_t* inst) {
     if (bRunDtor) {
         auto wasmInst = get_module_inst(pInst->pMainExecEnv);
         wasm_function_inst_t wasmFuncInst = wasm_runtime_lookup_function(wasmInst, "__wasm_call_dtors", "()");
-        if (wasmFuncInst)
+        if (wasmFuncInst) {
+            WAMR_EXT_NS::EnsureWasmThreadEnv();
+            WAMR_EXT_NS::WasiPthreadExt::BeginCPUTimeAccounting(pInst->pMainExecEnv);
             wasm_runtime_call_wasm_a(pInst->pMainExecEnv, wasmFuncInst, 0, nullptr, 0, nullptr);
+            WAMR_EXT_NS::WasiPthreadExt::EndCPUTimeAccounting(pInst->pMainExecEnv);
+        }
     }
+    if (pInst->wasmMainInstance && !pInst->config.pgoProfileFile.empty())
+        WAMR_EXT_NS::WamrExtDumpPGOProfile(pInst, pInst->config.pgoProfileFile.c_str());
     if (pInst->wasmMainInstance) {
         // Close all FDs opened by app
         std::vector<uint32_t> appFDs;
@@ -447,13 +1163,188 @@ WAMR_EXT_API int32_t wamr_ext_instance_destroy(wamr_ext_instance_t* inst) {
     if (pInst->wasmMainInstance)
         wasm_runtime_deinstantiate(pInst->wasmMainInstance);
     pInst->wasmMainInstance = nullptr;
-    std::lock_guard<std::mutex> instAL(pInst->instanceLock);
-    // Mark this instance destroyed first, then destroy finally in the loop thread
-    pInst->state = WamrExtInstance::STATE_DESTROYED;
+    {
+        std::lock_guard<std::mutex> instAL(pInst->instanceLock);
+        // Mark this instance destroyed first, then destroy finally in the loop thread
+        pInst->state = WamrExtInstance::STATE_DESTROYED;
+        if (pInst->pCheckTimer)
+            pInst->pCheckTimer->Cancel();
+    }
+    _al.unlock();
     *inst = nullptr;
+    // Exception callbacks reported before may be still queued in gCallbackLoop, wait for them after the instance is released
+    // in its loop thread, so that no callback of the instance is called after returning. Don't wait inside a callback.
+    auto pReleased = std::make_shared<WAMR_EXT_NS::Completion>();
+    auto& instLoop = WAMR_EXT_NS::gInstanceLoopPool.GetLoopThread((uintptr_t)pInst);
+    bool bPosted = instLoop.PostTaskAndReply([pHold]() {
+        if (WAMR_EXT_NS::CheckInstance(pHold))
+            WAMR_EXT_NS::gAllInstances.Remove(pHold.get());
+    }, [pReleased]() {
+        pReleased->Signal();
+    }, &WAMR_EXT_NS::gCallbackLoop);
+    if (bPosted && !WAMR_EXT_NS::gCallbackLoop.IsCurrentThread())
+        pReleased->Wait();
+    return 0;
+}
+
+int32_t wamr_ext_instance_terminate(wamr_ext_instance_t* inst) {
+    if (!inst || !(*inst))
+        return EINVAL;
+    auto pInst = *inst;
+    std::lock_guard<std::mutex> instAL(pInst->instanceLock);
+    if (pInst->state != WamrExtInstance::STATE_STARTED) {
+        snprintf(WAMR_EXT_NS::gLastErrorStr, sizeof(WAMR_EXT_NS::gLastErrorStr), "Instance not started");
+        return -1;
+    }
+    WAMR_EXT_NS::TerminateInstance(pInst, "terminated by host");
+    return 0;
+}
+
+int32_t wamr_ext_instance_acquire_buffer(wamr_ext_instance_t* inst, uint32_t size, WamrExtBuffer* buf) {
+    if (!inst || !(*inst) || size == 0 || !buf)
+        return EINVAL;
+    auto pInst = *inst;
+    std::lock_guard<std::mutex> instAL(pInst->instanceLock);
+    if (pInst->state != WamrExtInstance::STATE_STARTED) {
+        snprintf(WAMR_EXT_NS::gLastErrorStr, sizeof(WAMR_EXT_NS::gLastErrorStr), "Instance not started");
+        return -1;
+    }
+    uint32_t offset = 0;
+    if (pInst->pIOBufferAllocator && pInst->pIOBufferAllocator->Acquire(size, offset)) {
+        buf->app_offset = pInst->ioBufferAppOffset + offset;
+    } else {
+        // Fall back to the app heap if the ring buffer is disabled or full
+        void* _p;
+        buf->app_offset = wasm_runtime_module_malloc(pInst->wasmMainInstance, size, &_p);
+        if (buf->app_offset == 0)
+            return ENOMEM;
+    }
+    buf->host_ptr = wasm_runtime_addr_app_to_native(pInst->wasmMainInstance, buf->app_offset);
+    buf->size = size;
     return 0;
 }
 
+int32_t wamr_ext_instance_release_buffer(wamr_ext_instance_t* inst, const WamrExtBuffer* buf) {
+    if (!inst || !(*inst) || !buf)
+        return EINVAL;
+    auto pInst = *inst;
+    std::lock_guard<std::mutex> instAL(pInst->instanceLock);
+    // All buffers have been freed together with the app heap
+    if (pInst->state != WamrExtInstance::STATE_STARTED && pInst->state != WamrExtInstance::STATE_ENDED)
+        return 0;
+    if (pInst->pIOBufferAllocator && buf->app_offset >= pInst->ioBufferAppOffset &&
+        buf->app_offset < pInst->ioBufferAppOffset + pInst->pIOBufferAllocator->GetCapacity()) {
+        return pInst->pIOBufferAllocator->Release(buf->app_offset - pInst->ioBufferAppOffset) ? 0 : EINVAL;
+    }
+    wasm_runtime_module_free(pInst->wasmMainInstance, buf->app_offset);
+    return 0;
+}
+
+int32_t wamr_ext_instance_map_app_buffer(wamr_ext_instance_t* inst, uint32_t app_offset, uint32_t size, void** host_ptr) {
+    if (!inst || !(*inst) || !host_ptr)
+        return EINVAL;
+    auto pInst = *inst;
+    std::lock_guard<std::mutex> instAL(pInst->instanceLock);
+    if (pInst->state != WamrExtInstance::STATE_STARTED && pInst->state != WamrExtInstance::STATE_ENDED) {
+        snprintf(WAMR_EXT_NS::gLastErrorStr, sizeof(WAMR_EXT_NS::gLastErrorStr), "Instance not started");
+        return -1;
+    }
+    if (app_offset == 0 || !wasm_runtime_validate_app_addr(pInst->wasmMainInstance, app_offset, size))
+        return EFAULT;
+    *host_ptr = wasm_runtime_addr_app_to_native(pInst->wasmMainInstance, app_offset);
+    return 0;
+}
+
+int32_t wamr_ext_instance_dump_pgo_profile(wamr_ext_instance_t* inst, const char* file_path) {
+    if (!inst || !(*inst) || !file_path)
+        return EINVAL;
+    auto pInst = *inst;
+    std::lock_guard<std::mutex> _al(pInst->execFuncLock);
+    {
+        std::lock_guard<std::mutex> instAL(pInst->instanceLock);
+        if (pInst->state != WamrExtInstance::STATE_STARTED && pInst->state != WamrExtInstance::STATE_ENDED) {
+            snprintf(WAMR_EXT_NS::gLastErrorStr, sizeof(WAMR_EXT_NS::gLastErrorStr), "Instance not started");
+            return -1;
+        }
+    }
+    return WAMR_EXT_NS::WamrExtDumpPGOProfile(pInst, file_path);
+}
+
+int32_t wamr_ext_instance_get_cpu_time(wamr_ext_instance_t* inst, uint64_t* cpu_time_us) {
+    if (!inst || !(*inst) || !cpu_time_us)
+        return EINVAL;
+    auto* pInst = *inst;
+    {
+        std::lock_guard<std::mutex> instAL(pInst->instanceLock);
+        if (pInst->state == WamrExtInstance::STATE_STARTED)
+            WAMR_EXT_NS::WasiPthreadExt::SampleCPUTimeUsage(&pInst->wasiPthreadManager);
+    }
+    *cpu_time_us = pInst->wasiPthreadManager.GetCPUTimeUsageNs() / 1000;
+    return 0;
+}
+
+int32_t wamr_ext_instance_get_stats(wamr_ext_instance_t* inst, struct WamrExtInstanceStats* stats) {
+    if (!inst || !(*inst) || !stats)
+        return EINVAL;
+    auto* pInst = *inst;
+    memset(stats, 0, sizeof(WamrExtInstanceStats));
+    // The wasm instance is deinstantiated only after the instance leaves the started state
+    std::lock_guard<std::mutex> instAL(pInst->instanceLock);
+    if (pInst->state != WamrExtInstance::STATE_STARTED) {
+        snprintf(WAMR_EXT_NS::gLastErrorStr, sizeof(WAMR_EXT_NS::gLastErrorStr), "Instance not started");
+        return -1;
+    }
+    WASMMemoryInstance* memInst = wasm_get_default_memory((WASMModuleInstance*)pInst->wasmMainInstance);
+    if (memInst) {
+        stats->memory_size = uint64_t(memInst->num_bytes_per_page) * memInst->cur_page_count;
+        stats->memory_max_size = uint64_t(memInst->num_bytes_per_page) * memInst->max_page_count;
+        if (memInst->memory_data)
+            stats->memory_resident_size = WAMR_EXT_NS::Utility::GetResidentSize(memInst->memory_data, stats->memory_size);
+        mem_alloc_info_t allocInfo = {0};
+        if (memInst->heap_handle && mem_allocator_get_alloc_info(memInst->heap_handle, &allocInfo)) {
+            stats->app_heap_size = allocInfo.total_size;
+            stats->app_heap_free_size = allocInfo.total_free_size;
+            stats->app_heap_highmark_size = allocInfo.highmark_size;
+        }
+    }
+    stats->thread_count = pInst->wasiPthreadManager.GetRunningThreadCount() + 1;
+    uvwasi_t *pUVWasi = &wasm_runtime_get_wasi_ctx(pInst->wasmMainInstance)->uvwasi;
+    uvwasi_fd_table_lock(pUVWasi->fds);
+    for (uint32_t i = 0; i < pUVWasi->fds->size; i++) {
+        if (pUVWasi->fds->fds[i])
+            stats->fd_count++;
+    }
+    uvwasi_fd_table_unlock(pUVWasi->fds);
+    stats->child_process_count = pInst->wasiProcessManager.GetChildProcCount();
+    stats->cpu_time_us = pInst->wasiPthreadManager.GetCPUTimeUsageNs() / 1000;
+    return 0;
+}
+
+int32_t wamr_ext_instance_get_syscall_stats(wamr_ext_instance_t* inst, struct WamrExtSyscallStats* stats, uint32_t* count) {
+    if (!inst || !(*inst) || !count || (!stats && *count > 0))
+        return EINVAL;
+    auto statsList = (*inst)->syscallStats.Collect();
+    uint32_t copyCount = std::min(*count, (uint32_t)statsList.size());
+    if (copyCount > 0)
+        memcpy(stats, statsList.data(), copyCount * sizeof(WamrExtSyscallStats));
+    *count = statsList.size();
+    return copyCount < statsList.size() ? ERANGE : 0;
+}
+
+int32_t wamr_ext_profiler_start(uint32_t sample_hz) {
+    return WAMR_EXT_NS::WamrExtProfiler::Start(sample_hz);
+}
+
+int32_t wamr_ext_profiler_stop() {
+    return WAMR_EXT_NS::WamrExtProfiler::Stop();
+}
+
+int32_t wamr_ext_profiler_dump(const char* file_path) {
+    if (!file_path)
+        return EINVAL;
+    return WAMR_EXT_NS::WamrExtProfiler::Dump(file_path);
+}
+
 const char* wamr_ext_strerror(int32_t err) {
     if (err >= 0)
         return strerror(err);
@@ -26,6 +26,13 @@ int main(int argc, char** argv) {
         help("map host directories to the path accessed by Wasm app, eg: --dir /host/p1:/wasm/p1 --dir /host/p2:/wasm/p2");
     ap.add_argument("--cmd").default_value<std::vector<std::string>>({}).append().
         help("map command name used by Wasm app to host command path, eg: --cmd uname:uname --cmd ping:/usr/bin/ping");
+    ap.add_argument("--pgo-profile").default_value(std::string()).
+        help("dump PGO profile data to the file when the wasm app exits, the app must be compiled by wamr-ext-aot.py --instrument");
+    ap.add_argument("--perf-map").default_value(false).implicit_value(true).
+        help("write symbols of AOT functions to /tmp/perf-<pid>.map for Linux perf");
+    ap.add_argument("--profile").default_value(std::string()).
+        help("sample wasm call stacks and write them in collapsed stack format to the file when the wasm app exits");
+    ap.add_argument("--profile-hz").help("sample rate of --profile").scan<'i', int>().default_value(99);
     ap.add_argument("file_and_args").help("Wasm app file to load and arguments passed to main() of the wasm app").remaining();
     try {
         ap.parse_args(argc, argv);
@@ -35,6 +42,8 @@ int main(int argc, char** argv) {
         std::exit(1);
     }
     int32_t maxMemory = ap.get<int>("--max-memory");
+    std::string pgoProfileFile = ap.get<std::string>("--pgo-profile");
+    std::string profileFile = ap.get<std::string>("--profile");
     std::vector<std::string> progArgs = ap.get<std::vector<std::string>>("file_and_args");
     std::string wasmAppFile = progArgs.front();
     char** mainArgv = new char*[progArgs.size() + 1];
@@ -43,6 +52,10 @@ int main(int argc, char** argv) {
     mainArgv[progArgs.size()] = nullptr;
 
     wamr_ext_init();
+    if (ap.get<bool>("--perf-map")) {
+        uint32_t bEnabled = 1;
+        wamr_ext_set_global_opt(WAMR_EXT_GLOBAL_OPT_PERF_MAP, &bEnabled);
+    }
     wamr_ext_module_t module;
     int err = wamr_ext_module_load_by_file(&module, std::filesystem::path(wasmAppFile).stem().string().c_str(), wasmAppFile.c_str());
     if (err != 0) {
@@ -51,6 +64,8 @@ int main(int argc, char** argv) {
     }
     if (maxMemory > 0)
         wamr_ext_module_set_inst_default_opt(&module, WAMR_EXT_INST_OPT_MAX_MEMORY, &maxMemory);
+    if (!pgoProfileFile.empty())
+        wamr_ext_module_set_inst_default_opt(&module, WAMR_EXT_INST_OPT_PGO_PROFILE_FILE, pgoProfileFile.c_str());
     auto mapDirs = ap.get<std::vector<std::string>>("--dir");
     for (const auto& strMapDir : mapDirs) {
         std::string hostDir;
@@ -92,12 +107,21 @@ int main(int argc, char** argv) {
         printf("Failed to start wasm app: %s\n", wamr_ext_strerror(err));
         return err;
     }
+    if (!profileFile.empty()) {
+        err = wamr_ext_profiler_start(ap.get<int>("--profile-hz"));
+        if (err != 0)
+            printf("Failed to start profiler: %s\n", wamr_ext_strerror(err));
+    }
     int32_t mainRetVal = 233;
     err = wamr_ext_instance_exec_main_func(&inst, &mainRetVal);
     if (err != 0) {
         printf("Failed to execute main() of wasm app: %s\n", wamr_ext_strerror(err));
         _Exit(err);
     }
+    if (!profileFile.empty()) {
+        wamr_ext_profiler_stop();
+        wamr_ext_profiler_dump(profileFile.c_str());
+    }
     delete[] mainArgv;
     wamr_ext_instance_destroy(&inst);
     return err == 0 ? mainRetVal : err;
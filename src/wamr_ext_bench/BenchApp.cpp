@@ -0,0 +1,505 @@
+#include <argparse/argparse.hpp>
+#include <wamr_ext_api.h>
+#include "BenchWasmModule.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <condition_variable>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+struct BenchConfig {
+    uint32_t iterations;
+    uint32_t threads;
+    int32_t fibN;
+    std::string workloadDir;
+};
+
+struct BenchResult {
+    std::string name;
+    std::string error;
+    uint64_t ops{0};
+    double totalMs{0};
+    // Microseconds of each operation, empty if only the throughput is measured
+    std::vector<double> latenciesUs;
+    uint64_t rssKB{0};
+    uint64_t peakRssKB{0};
+};
+
+struct BenchCase {
+    const char* name;
+    std::function<void(const BenchConfig&, BenchResult&)> func;
+};
+
+typedef std::chrono::steady_clock BenchClock;
+
+static double ElapsedUs(BenchClock::time_point begin, BenchClock::time_point end) {
+    return std::chrono::duration<double, std::micro>(end - begin).count();
+}
+
+// Read VmRSS/VmHWM(KB) from /proc/self/status, 0 if unavailable
+static uint64_t GetProcStatusKB(const char* key) {
+    std::ifstream f("/proc/self/status");
+    std::string line;
+    size_t keyLen = strlen(key);
+    while (std::getline(f, line)) {
+        if (line.compare(0, keyLen, key) == 0 && line.size() > keyLen && line[keyLen] == ':')
+            return strtoull(line.c_str() + keyLen + 1, nullptr, 10);
+    }
+    return 0;
+}
+
+static std::string JsonEscape(const std::string& str) {
+    std::string ret;
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            ret += '\\';
+            ret += c;
+        } else if ((unsigned char)c < 0x20) {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", c);
+            ret += buf;
+        } else {
+            ret += c;
+        }
+    }
+    return ret;
+}
+
+static double Percentile(const std::vector<double>& sorted, double p) {
+    size_t idx = std::min(sorted.size() - 1, (size_t)(p / 100 * sorted.size()));
+    return sorted[idx];
+}
+
+static void PrintResults(std::vector<BenchResult>& results, FILE* out) {
+    const char* version = nullptr;
+    wamr_ext_version(&version, nullptr);
+    fprintf(out, "{\n  \"version\": \"%s\",\n  \"results\": [", version);
+    for (size_t i = 0; i < results.size(); i++) {
+        auto& r = results[i];
+        fprintf(out, "%s\n    {\"name\": \"%s\"", i == 0 ? "" : ",", r.name.c_str());
+        if (!r.error.empty()) {
+            fprintf(out, ", \"error\": \"%s\"}", JsonEscape(r.error).c_str());
+            continue;
+        }
+        fprintf(out, ", \"ops\": %" PRIu64 ", \"total_ms\": %.3f, \"ops_per_sec\": %.1f",
+                r.ops, r.totalMs, r.totalMs > 0 ? r.ops * 1000.0 / r.totalMs : 0.0);
+        if (!r.latenciesUs.empty()) {
+            std::sort(r.latenciesUs.begin(), r.latenciesUs.end());
+            fprintf(out, ", \"latency_us\": {\"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f}",
+                    Percentile(r.latenciesUs, 50), Percentile(r.latenciesUs, 90), Percentile(r.latenciesUs, 99),
+                    r.latenciesUs.back());
+        }
+        fprintf(out, ", \"rss_kb\": %" PRIu64 ", \"peak_rss_kb\": %" PRIu64 "}", r.rssKB, r.peakRssKB);
+    }
+    fprintf(out, "\n  ]\n}\n");
+}
+
+// Run op iterations times and record the latency of each
+static void RunTimed(uint32_t iterations, BenchResult& result, const std::function<bool(uint32_t)>& op) {
+    result.latenciesUs.reserve(iterations);
+    auto benchBegin = BenchClock::now();
+    for (uint32_t i = 0; i < iterations; i++) {
+        auto opBegin = BenchClock::now();
+        if (!op(i)) {
+            if (result.error.empty())
+                result.error = "operation failed at iteration " + std::to_string(i);
+            return;
+        }
+        result.latenciesUs.push_back(ElapsedUs(opBegin, BenchClock::now()));
+    }
+    result.totalMs = ElapsedUs(benchBegin, BenchClock::now()) / 1000;
+    result.ops = iterations;
+}
+
+static bool CheckErr(int32_t err, const char* what, BenchResult& result) {
+    if (err == 0)
+        return true;
+    if (result.error.empty())
+        result.error = std::string(what) + ": " + wamr_ext_strerror(err);
+    return false;
+}
+
+// The built-in module with a custom section carrying seq, so that each copy has different content and is not
+// shared with previously loaded modules
+static std::vector<uint8_t> MakeUniqueBenchModule(uint64_t seq) {
+    std::vector<uint8_t> buf(gBenchWasmModule, gBenchWasmModule + sizeof(gBenchWasmModule));
+    const uint8_t sectionHeader[] = {0x00, 14, 5, 'b', 'e', 'n', 'c', 'h'};
+    buf.insert(buf.end(), sectionHeader, sectionHeader + sizeof(sectionHeader));
+    for (int i = 0; i < 8; i++)
+        buf.push_back((uint8_t)(seq >> (i * 8)));
+    return buf;
+}
+
+static std::atomic<uint64_t> gModuleSeq{0};
+
+static wamr_ext_module_t LoadBenchModule(bool bUnique, BenchResult& result) {
+    uint64_t seq = gModuleSeq++;
+    std::string moduleName = "bench_" + std::to_string(seq);
+    std::vector<uint8_t> buf = bUnique ? MakeUniqueBenchModule(seq) :
+                               std::vector<uint8_t>(gBenchWasmModule, gBenchWasmModule + sizeof(gBenchWasmModule));
+    wamr_ext_module_t module = nullptr;
+    if (!CheckErr(wamr_ext_module_load_by_buffer(&module, moduleName.c_str(), buf.data(), buf.size()), "load module", result))
+        return nullptr;
+    return module;
+}
+
+// inst is kept by the instance as the callback pointer, it must outlive the instance
+static bool StartInstance(wamr_ext_module_t module, wamr_ext_instance_t* inst, BenchResult& result) {
+    if (!CheckErr(wamr_ext_instance_create(&module, inst), "create instance", result))
+        return false;
+    if (!CheckErr(wamr_ext_instance_start(inst), "start instance", result)) {
+        wamr_ext_instance_destroy(inst);
+        return false;
+    }
+    return true;
+}
+
+// Call a function taking and returning one i32 in a started instance
+class I32Caller {
+public:
+    I32Caller(wamr_ext_instance_t* inst, const char* funcName, BenchResult& result) : m_inst(inst), m_result(result) {
+        m_bOK = CheckErr(wamr_ext_instance_lookup_func(m_inst, funcName, &m_func), funcName, result);
+    }
+    bool IsOK() const { return m_bOK; }
+    bool Call(int32_t arg, int32_t* ret) {
+        WamrExtValue argVal;
+        argVal.kind = WAMR_EXT_VALUE_I32;
+        argVal.of.i32 = arg;
+        WamrExtValue retVal;
+        if (!CheckErr(wamr_ext_instance_call_func(m_inst, &m_func, &argVal, 1, &retVal, 1), "call function", m_result))
+            return false;
+        *ret = retVal.of.i32;
+        return true;
+    }
+private:
+    wamr_ext_instance_t* m_inst;
+    wamr_ext_func_t m_func{nullptr};
+    BenchResult& m_result;
+    bool m_bOK;
+};
+
+static void BenchModuleLoad(bool bUnique, const BenchConfig& conf, BenchResult& result) {
+    // Modules are never unloaded, limit the number to keep memory bounded
+    RunTimed(std::min(conf.iterations, 1000u), result, [&](uint32_t) {
+        return LoadBenchModule(bUnique, result) != nullptr;
+    });
+}
+
+static void BenchInstanceLifecycle(const BenchConfig& conf, BenchResult& result) {
+    wamr_ext_module_t module = LoadBenchModule(false, result);
+    if (!module)
+        return;
+    RunTimed(conf.iterations, result, [&](uint32_t) {
+        wamr_ext_instance_t inst;
+        if (!StartInstance(module, &inst, result))
+            return false;
+        wamr_ext_instance_destroy(&inst);
+        return true;
+    });
+}
+
+// Create, start and destroy instances of one module in parallel threads
+static void BenchInstanceLifecycleParallel(const BenchConfig& conf, BenchResult& result) {
+    wamr_ext_module_t module = LoadBenchModule(false, result);
+    if (!module)
+        return;
+    uint32_t opsPerThread = std::max(conf.iterations / conf.threads, 1u);
+    std::vector<BenchResult> threadResults(conf.threads);
+    std::vector<std::thread> threads;
+    auto benchBegin = BenchClock::now();
+    for (uint32_t t = 0; t < conf.threads; t++) {
+        threads.emplace_back([&, t]() {
+            RunTimed(opsPerThread, threadResults[t], [&](uint32_t) {
+                wamr_ext_instance_t inst;
+                if (!StartInstance(module, &inst, threadResults[t]))
+                    return false;
+                wamr_ext_instance_destroy(&inst);
+                return true;
+            });
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    result.totalMs = ElapsedUs(benchBegin, BenchClock::now()) / 1000;
+    for (auto& threadResult : threadResults) {
+        if (!threadResult.error.empty()) {
+            result.error = threadResult.error;
+            return;
+        }
+        result.ops += threadResult.ops;
+        result.latenciesUs.insert(result.latenciesUs.end(), threadResult.latenciesUs.begin(), threadResult.latenciesUs.end());
+    }
+}
+
+// Call funcName(arg) of the built-in module in a started instance
+static void BenchCall(const char* funcName, int32_t arg, int32_t expected, const BenchConfig& conf, BenchResult& result) {
+    wamr_ext_module_t module = LoadBenchModule(false, result);
+    if (!module)
+        return;
+    wamr_ext_instance_t inst;
+    if (!StartInstance(module, &inst, result))
+        return;
+    I32Caller caller(&inst, funcName, result);
+    if (caller.IsOK()) {
+        RunTimed(conf.iterations, result, [&](uint32_t) {
+            int32_t ret = 0;
+            if (!caller.Call(arg, &ret))
+                return false;
+            if (expected >= 0 && ret != expected) {
+                result.error = std::string("unexpected result of ") + funcName;
+                return false;
+            }
+            return true;
+        });
+    }
+    wamr_ext_instance_destroy(&inst);
+}
+
+// Each call arms and cancels an execution timeout timer, run in parallel threads to measure timers/sec of the loop threads.
+// The timeout is long, so cancelled timers piling up in the timer wheel show up in rss_kb.
+static void BenchCallTimeout(const BenchConfig& conf, BenchResult& result) {
+    wamr_ext_module_t module = LoadBenchModule(false, result);
+    if (!module)
+        return;
+    uint32_t opsPerThread = std::max(conf.iterations / conf.threads, 1u);
+    std::vector<BenchResult> threadResults(conf.threads);
+    std::vector<wamr_ext_instance_t> insts(conf.threads);
+    std::vector<std::thread> threads;
+    auto benchBegin = BenchClock::now();
+    for (uint32_t t = 0; t < conf.threads; t++) {
+        threads.emplace_back([&, t]() {
+            auto& threadResult = threadResults[t];
+            if (!CheckErr(wamr_ext_instance_create(&module, &insts[t]), "create instance", threadResult))
+                return;
+            uint32_t execTimeout = 60 * 1000;
+            if (!CheckErr(wamr_ext_instance_set_opt(&insts[t], WAMR_EXT_INST_OPT_EXEC_TIMEOUT, &execTimeout), "set exec timeout", threadResult) ||
+                !CheckErr(wamr_ext_instance_start(&insts[t]), "start instance", threadResult)) {
+                wamr_ext_instance_destroy(&insts[t]);
+                return;
+            }
+            I32Caller caller(&insts[t], "fib", threadResult);
+            if (caller.IsOK()) {
+                RunTimed(opsPerThread, threadResult, [&](uint32_t) {
+                    int32_t ret = 0;
+                    return caller.Call(1, &ret);
+                });
+            }
+            wamr_ext_instance_destroy(&insts[t]);
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    result.totalMs = ElapsedUs(benchBegin, BenchClock::now()) / 1000;
+    for (auto& threadResult : threadResults) {
+        if (!threadResult.error.empty()) {
+            result.error = threadResult.error;
+            return;
+        }
+        result.ops += threadResult.ops;
+        result.latenciesUs.insert(result.latenciesUs.end(), threadResult.latenciesUs.begin(), threadResult.latenciesUs.end());
+    }
+}
+
+static int32_t Fib(int32_t n) {
+    uint32_t a = 0, b = 1;
+    for (; n > 0; n--) {
+        uint32_t t = a + b;
+        a = b;
+        b = t;
+    }
+    return (int32_t)a;
+}
+
+// Latency from submitting an async call to its completion callback
+static void BenchCallAsync(const BenchConfig& conf, BenchResult& result) {
+    wamr_ext_module_t module = LoadBenchModule(false, result);
+    if (!module)
+        return;
+    wamr_ext_instance_t inst;
+    if (!StartInstance(module, &inst, result))
+        return;
+    struct AsyncState {
+        std::mutex lock;
+        std::condition_variable cond;
+        std::vector<BenchClock::time_point> submitTimes;
+        std::vector<double> latenciesUs;
+        uint32_t pendingCount{0};
+        int32_t err{0};
+    } state;
+    struct AsyncCall {
+        AsyncState* pState;
+        uint32_t index;
+    };
+    std::vector<AsyncCall> calls(conf.iterations);
+    state.submitTimes.resize(conf.iterations);
+    state.latenciesUs.resize(conf.iterations);
+    state.pendingCount = conf.iterations;
+    WamrExtValue arg;
+    arg.kind = WAMR_EXT_VALUE_I32;
+    arg.of.i32 = 1;
+    auto benchBegin = BenchClock::now();
+    uint32_t submitted = 0;
+    for (; submitted < conf.iterations; submitted++) {
+        calls[submitted] = {&state, submitted};
+        WamrExtCallCompletionCB cb;
+        cb.func = [](int32_t err, const WamrExtValue*, uint32_t, void* userData) {
+            auto pCall = static_cast<AsyncCall*>(userData);
+            auto now = BenchClock::now();
+            std::lock_guard<std::mutex> _al(pCall->pState->lock);
+            pCall->pState->latenciesUs[pCall->index] = ElapsedUs(pCall->pState->submitTimes[pCall->index], now);
+            if (err != 0)
+                pCall->pState->err = err;
+            if (--pCall->pState->pendingCount == 0)
+                pCall->pState->cond.notify_all();
+        };
+        cb.user_data = &calls[submitted];
+        {
+            std::lock_guard<std::mutex> _al(state.lock);
+            state.submitTimes[submitted] = BenchClock::now();
+        }
+        if (!CheckErr(wamr_ext_instance_call_async(&inst, "fib", &arg, 1, &cb), "submit async call", result))
+            break;
+    }
+    {
+        std::unique_lock<std::mutex> _al(state.lock);
+        state.pendingCount -= conf.iterations - submitted;
+        state.cond.wait(_al, [&]() { return state.pendingCount == 0; });
+    }
+    result.totalMs = ElapsedUs(benchBegin, BenchClock::now()) / 1000;
+    if (result.error.empty() && CheckErr(state.err, "async call", result)) {
+        result.ops = conf.iterations;
+        result.latenciesUs = std::move(state.latenciesUs);
+    }
+    wamr_ext_instance_destroy(&inst);
+}
+
+// Run bench_op(i) exported by a workload built from workloads/*.c
+static void BenchWorkload(const char* workloadName, const BenchConfig& conf, BenchResult& result) {
+    std::string wasmFile = (std::filesystem::path(conf.workloadDir) / workloadName).string() + ".wasm";
+    if (!std::filesystem::exists(wasmFile)) {
+        result.error = wasmFile + " does not exist";
+        return;
+    }
+    wamr_ext_module_t module = nullptr;
+    std::string moduleName = std::string("bench_") + workloadName;
+    if (!CheckErr(wamr_ext_module_load_by_file(&module, moduleName.c_str(), wasmFile.c_str()), "load workload", result))
+        return;
+    wamr_ext_instance_t inst;
+    if (!StartInstance(module, &inst, result))
+        return;
+    wamr_ext_func_t setupFunc = nullptr;
+    int32_t setupRet = 0;
+    if (wamr_ext_instance_lookup_func(&inst, "bench_setup", &setupFunc) == 0) {
+        WamrExtValue retVal;
+        if (CheckErr(wamr_ext_instance_call_func(&inst, &setupFunc, nullptr, 0, &retVal, 1), "bench_setup", result))
+            setupRet = retVal.of.i32;
+    }
+    if (result.error.empty() && setupRet != 0)
+        result.error = "bench_setup returns " + std::to_string(setupRet);
+    I32Caller caller(&inst, "bench_op", result);
+    if (result.error.empty() && caller.IsOK()) {
+        RunTimed(conf.iterations, result, [&](uint32_t i) {
+            int32_t ret = 0;
+            if (!caller.Call((int32_t)i, &ret))
+                return false;
+            if (ret != 0) {
+                result.error = "bench_op returns " + std::to_string(ret);
+                return false;
+            }
+            return true;
+        });
+    }
+    wamr_ext_instance_destroy(&inst);
+}
+
+int main(int argc, char** argv) {
+    const char* version = nullptr;
+    wamr_ext_version(&version, nullptr);
+    argparse::ArgumentParser ap("wamr_ext_bench", version);
+    ap.add_argument("--iterations").help("operations of each benchmark").scan<'i', int>().default_value(10000);
+    ap.add_argument("--threads").help("threads of parallel benchmarks, 0 means the number of CPUs").scan<'i', int>().default_value(0);
+    ap.add_argument("--fib").help("argument of the compute benchmark fib(n)").scan<'i', int>().default_value(10000);
+    ap.add_argument("--filter").default_value(std::string()).help("only run benchmarks whose names contain the string");
+    ap.add_argument("--workload-dir").default_value(std::string()).
+        help("directory of workload wasm files built from src/wamr_ext_bench/workloads, workload benchmarks are skipped if not set");
+    ap.add_argument("-o").default_value(std::string()).help("write JSON results to the file instead of stdout");
+    ap.add_argument("--list").default_value(false).implicit_value(true).help("list benchmarks and exit");
+    try {
+        ap.parse_args(argc, argv);
+    } catch (const std::runtime_error &err) {
+        std::cerr << err.what() << std::endl;
+        std::cerr << ap;
+        std::exit(1);
+    }
+    BenchConfig conf;
+    conf.iterations = std::max(ap.get<int>("--iterations"), 1);
+    conf.threads = ap.get<int>("--threads") > 0 ? ap.get<int>("--threads") : std::max(std::thread::hardware_concurrency(), 1u);
+    conf.fibN = ap.get<int>("--fib");
+    conf.workloadDir = ap.get<std::string>("--workload-dir");
+    std::string filter = ap.get<std::string>("--filter");
+
+    std::vector<BenchCase> benchCases = {
+        {"module_load", [](const BenchConfig& conf, BenchResult& result) { BenchModuleLoad(true, conf, result); }},
+        {"module_load_shared", [](const BenchConfig& conf, BenchResult& result) { BenchModuleLoad(false, conf, result); }},
+        {"instance_lifecycle", BenchInstanceLifecycle},
+        {"instance_lifecycle_parallel", BenchInstanceLifecycleParallel},
+        {"call_overhead", [](const BenchConfig& conf, BenchResult& result) { BenchCall("fib", 1, 1, conf, result); }},
+        {"call_async", BenchCallAsync},
+        {"call_timeout_timers", BenchCallTimeout},
+        {"compute_fib", [](const BenchConfig& conf, BenchResult& result) {
+            BenchCall("fib", conf.fibN, Fib(conf.fibN), conf, result);
+        }},
+        {"memory_checksum", [](const BenchConfig& conf, BenchResult& result) {
+            BenchCall("checksum", WAMR_EXT_BENCH_CHECKSUM_LEN, -1, conf, result);
+        }},
+    };
+    if (!conf.workloadDir.empty()) {
+        for (const char* workloadName : {"syscall_pingpong", "socket_echo", "thread_spawn"}) {
+            benchCases.push_back({workloadName, [workloadName](const BenchConfig& conf, BenchResult& result) {
+                BenchWorkload(workloadName, conf, result);
+            }});
+        }
+    }
+    if (ap.get<bool>("--list")) {
+        for (const auto& benchCase : benchCases)
+            printf("%s\n", benchCase.name);
+        return 0;
+    }
+
+    int32_t err = wamr_ext_init();
+    if (err != 0) {
+        fprintf(stderr, "Failed to init wamr-ext: %s\n", wamr_ext_strerror(err));
+        return 1;
+    }
+    std::vector<BenchResult> results;
+    for (const auto& benchCase : benchCases) {
+        if (!filter.empty() && strstr(benchCase.name, filter.c_str()) == nullptr)
+            continue;
+        fprintf(stderr, "Running %s...\n", benchCase.name);
+        BenchResult result;
+        result.name = benchCase.name;
+        benchCase.func(conf, result);
+        result.rssKB = GetProcStatusKB("VmRSS");
+        result.peakRssKB = GetProcStatusKB("VmHWM");
+        if (!result.error.empty())
+            fprintf(stderr, "%s failed: %s\n", benchCase.name, result.error.c_str());
+        results.push_back(std::move(result));
+    }
+    std::string outFile = ap.get<std::string>("-o");
+    FILE* out = outFile.empty() ? stdout : fopen(outFile.c_str(), "w");
+    if (!out) {
+        fprintf(stderr, "Failed to open %s: %s\n", outFile.c_str(), strerror(errno));
+        return 1;
+    }
+    PrintResults(results, out);
+    if (out != stdout)
+        fclose(out);
+    bool bAllPassed = std::all_of(results.begin(), results.end(), [](const BenchResult& r) { return r.error.empty(); });
+    return bAllPassed ? 0 : 1;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+
+// Bytes hashed by checksum(), the whole linear memory
+#define WAMR_EXT_BENCH_CHECKSUM_LEN 65536
+
+// Built-in workload module, so that the benchmark can run without a wasm toolchain:
+// (module
+//   (memory (export "memory") 1 1)
+//   (func (export "_initialize"))
+//   ;; Iterative Fibonacci, compute-bound
+//   (func (export "fib") (param $n i32) (result i32) (local $a i32) (local $b i32) (local $t i32)
+//     (local.set $a (i32.const 0)) (local.set $b (i32.const 1))
+//     (block (loop
+//       (br_if 1 (i32.eqz (local.get $n)))
+//       (local.set $t (i32.add (local.get $a) (local.get $b)))
+//       (local.set $a (local.get $b)) (local.set $b (local.get $t))
+//       (local.set $n (i32.sub (local.get $n) (i32.const 1)))
+//       (br 0)))
+//     (local.get $a))
+//   ;; Hash of linear memory bytes [0, len), memory access bound
+//   (func (export "checksum") (param $len i32) (result i32) (local $i i32) (local $h i32)
+//     (local.set $i (i32.const 0)) (local.set $h (i32.const 0))
+//     (block (loop
+//       (br_if 1 (i32.ge_u (local.get $i) (local.get $len)))
+//       (local.set $h (i32.add (i32.mul (local.get $h) (i32.const 31)) (i32.load8_u (local.get $i))))
+//       (local.set $i (i32.add (local.get $i) (i32.const 1)))
+//       (br 0)))
+//     (local.get $h)))
+static const uint8_t gBenchWasmModule[] = {
+        0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00, 0x01, 0x09, 0x02, 0x60, 0x00, 0x00, 0x60, 0x01,
+        0x7f, 0x01, 0x7f, 0x03, 0x04, 0x03, 0x00, 0x01, 0x01, 0x05, 0x04, 0x01, 0x01, 0x01, 0x01, 0x07,
+        0x29, 0x04, 0x06, 0x6d, 0x65, 0x6d, 0x6f, 0x72, 0x79, 0x02, 0x00, 0x0b, 0x5f, 0x69, 0x6e, 0x69,
+        0x74, 0x69, 0x61, 0x6c, 0x69, 0x7a, 0x65, 0x00, 0x00, 0x03, 0x66, 0x69, 0x62, 0x00, 0x01, 0x08,
+        0x63, 0x68, 0x65, 0x63, 0x6b, 0x73, 0x75, 0x6d, 0x00, 0x02, 0x0a, 0x68, 0x03, 0x02, 0x00, 0x0b,
+        0x31, 0x01, 0x03, 0x7f, 0x41, 0x00, 0x21, 0x01, 0x41, 0x01, 0x21, 0x02, 0x02, 0x40, 0x03, 0x40,
+        0x20, 0x00, 0x45, 0x0d, 0x01, 0x20, 0x01, 0x20, 0x02, 0x6a, 0x21, 0x03, 0x20, 0x02, 0x21, 0x01,
+        0x20, 0x03, 0x21, 0x02, 0x20, 0x00, 0x41, 0x01, 0x6b, 0x21, 0x00, 0x0c, 0x00, 0x0b, 0x0b, 0x20,
+        0x01, 0x0b, 0x31, 0x01, 0x02, 0x7f, 0x41, 0x00, 0x21, 0x01, 0x41, 0x00, 0x21, 0x02, 0x02, 0x40,
+        0x03, 0x40, 0x20, 0x01, 0x20, 0x00, 0x4f, 0x0d, 0x01, 0x20, 0x02, 0x41, 0x1f, 0x6c, 0x20, 0x01,
+        0x2d, 0x00, 0x00, 0x6a, 0x21, 0x02, 0x20, 0x01, 0x41, 0x01, 0x6a, 0x21, 0x01, 0x0c, 0x00, 0x0b,
+        0x0b, 0x20, 0x02, 0x0b,
+};
@@ -0,0 +1,7 @@
+#pragma once
+// Interface of workloads run by wamr_ext_bench, built as wasm reactors:
+// bench_setup() is called once after the instance starts, bench_op(i) is one timed operation.
+#define BENCH_EXPORT(name) __attribute__((export_name(name)))
+
+BENCH_EXPORT("bench_setup") int bench_setup(void);
+BENCH_EXPORT("bench_op") int bench_op(int i);
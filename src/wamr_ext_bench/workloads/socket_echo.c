@@ -0,0 +1,69 @@
+#include "bench_workload.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define ECHO_MSG_SIZE 64
+
+static int gClientFD = -1;
+
+static void* EchoServer(void* arg) {
+    int listenFD = (int)(long)arg;
+    int connFD = accept(listenFD, NULL, NULL);
+    close(listenFD);
+    if (connFD < 0)
+        return NULL;
+    char buf[ECHO_MSG_SIZE];
+    ssize_t n;
+    while ((n = recv(connFD, buf, sizeof(buf), 0)) > 0) {
+        if (send(connFD, buf, n, 0) != n)
+            break;
+    }
+    close(connFD);
+    return NULL;
+}
+
+// TCP echo over loopback, one round trip of a small message per operation
+int bench_setup(void) {
+    int listenFD = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenFD < 0)
+        return -1;
+    struct sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addrLen = sizeof(addr);
+    if (bind(listenFD, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(listenFD, 1) != 0 ||
+        getsockname(listenFD, (struct sockaddr*)&addr, &addrLen) != 0) {
+        close(listenFD);
+        return -1;
+    }
+    pthread_t serverThread;
+    if (pthread_create(&serverThread, NULL, EchoServer, (void*)(long)listenFD) != 0) {
+        close(listenFD);
+        return -1;
+    }
+    pthread_detach(serverThread);
+    gClientFD = socket(AF_INET, SOCK_STREAM, 0);
+    if (gClientFD < 0 || connect(gClientFD, (struct sockaddr*)&addr, sizeof(addr)) != 0)
+        return -1;
+    int noDelay = 1;
+    setsockopt(gClientFD, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    return 0;
+}
+
+int bench_op(int i) {
+    char buf[ECHO_MSG_SIZE] = {(char)i};
+    if (send(gClientFD, buf, sizeof(buf), 0) != sizeof(buf))
+        return -1;
+    size_t received = 0;
+    while (received < sizeof(buf)) {
+        ssize_t n = recv(gClientFD, buf + received, sizeof(buf) - received, 0);
+        if (n <= 0)
+            return -1;
+        received += n;
+    }
+    return 0;
+}
@@ -0,0 +1,21 @@
+#include "bench_workload.h"
+#include <pthread.h>
+
+static void* ThreadFunc(void* arg) {
+    return arg;
+}
+
+// Create and join one app thread per operation
+int bench_setup(void) {
+    return 0;
+}
+
+int bench_op(int i) {
+    pthread_t thread;
+    void* ret = NULL;
+    if (pthread_create(&thread, NULL, ThreadFunc, (void*)(long)i) != 0)
+        return -1;
+    if (pthread_join(thread, &ret) != 0)
+        return -1;
+    return (int)(long)ret == i ? 0 : -1;
+}
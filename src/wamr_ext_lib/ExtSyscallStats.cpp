@@ -0,0 +1,142 @@
+#include "ExtSyscallStats.h"
+#include <algorithm>
+
+namespace WAMR_EXT_NS {
+    std::atomic<bool> ExtSyscallStats::m_gEnabled{false};
+    std::atomic<uint64_t> ExtSyscallStats::m_gNextID{1};
+    std::vector<uint32_t> ExtSyscallStats::m_gSyscallIDs;
+
+    struct ExtSyscallStats::ThreadCacheEntry {
+        uint64_t statsID{0};
+        std::shared_ptr<ThreadBlock> pBlock;
+    };
+
+    // Blocks recently used by the current thread, a thread usually makes syscalls for only one instance
+    struct ExtSyscallStats::ThreadCache {
+        static constexpr size_t ENTRY_COUNT = 4;
+        ThreadCacheEntry entries[ENTRY_COUNT];
+        size_t nextEvictIndex{0};
+
+        ~ThreadCache() {
+            for (auto& entry : entries) {
+                if (entry.pBlock)
+                    entry.pBlock->bOwned.store(false, std::memory_order_release);
+            }
+        }
+    };
+
+    thread_local ExtSyscallStats::ThreadCache ExtSyscallStats::m_gThreadCache;
+
+    uint32_t ExtSyscallStats::RegisterSyscall(uint32_t syscallID) {
+        auto it = std::find(m_gSyscallIDs.begin(), m_gSyscallIDs.end(), syscallID);
+        if (it != m_gSyscallIDs.end())
+            return it - m_gSyscallIDs.begin();
+        m_gSyscallIDs.push_back(syscallID);
+        return m_gSyscallIDs.size() - 1;
+    }
+
+    uint32_t ExtSyscallStats::BucketOf(uint64_t value) {
+        if (value < (1u << SUB_BUCKET_BITS))
+            return value;
+        uint32_t magnitude = 63 - __builtin_clzll(value);
+        if (magnitude > MAX_MAGNITUDE)
+            return BUCKET_COUNT - 1;
+        uint32_t subBucket = (value >> (magnitude - SUB_BUCKET_BITS)) & ((1u << SUB_BUCKET_BITS) - 1);
+        return ((magnitude - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS) + subBucket;
+    }
+
+    uint64_t ExtSyscallStats::BucketUpperBound(uint32_t bucket) {
+        uint32_t group = bucket >> SUB_BUCKET_BITS;
+        if (group == 0)
+            return bucket;
+        uint32_t shift = group - 1;
+        uint64_t lowerBound = uint64_t((1u << SUB_BUCKET_BITS) + (bucket & ((1u << SUB_BUCKET_BITS) - 1))) << shift;
+        return lowerBound + (uint64_t(1) << shift) - 1;
+    }
+
+    ExtSyscallStats::ThreadBlock* ExtSyscallStats::GetThreadBlock() {
+        auto& cache = m_gThreadCache;
+        for (auto& entry : cache.entries) {
+            if (entry.statsID == m_id)
+                return entry.pBlock.get();
+        }
+        std::shared_ptr<ThreadBlock> pBlock;
+        {
+            std::lock_guard<std::mutex> _al(m_lock);
+            for (const auto& pFreeBlock : m_threadBlocks) {
+                if (!pFreeBlock->bOwned.load(std::memory_order_relaxed) && !pFreeBlock->bOwned.exchange(true, std::memory_order_acquire)) {
+                    pBlock = pFreeBlock;
+                    break;
+                }
+            }
+            if (!pBlock) {
+                pBlock = std::make_shared<ThreadBlock>(m_gSyscallIDs.size());
+                m_threadBlocks.push_back(pBlock);
+            }
+        }
+        auto& entry = cache.entries[cache.nextEvictIndex];
+        cache.nextEvictIndex = (cache.nextEvictIndex + 1) % ThreadCache::ENTRY_COUNT;
+        if (entry.pBlock)
+            entry.pBlock->bOwned.store(false, std::memory_order_release);
+        entry.statsID = m_id;
+        entry.pBlock = std::move(pBlock);
+        return entry.pBlock.get();
+    }
+
+    void ExtSyscallStats::Record(uint32_t syscallIndex, uint64_t latencyNs, bool bError) {
+        auto& counter = GetThreadBlock()->counters[syscallIndex];
+        counter.callCount.store(counter.callCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (bError)
+            counter.errorCount.store(counter.errorCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        counter.totalNs.store(counter.totalNs.load(std::memory_order_relaxed) + latencyNs, std::memory_order_relaxed);
+        if (latencyNs > counter.maxNs.load(std::memory_order_relaxed))
+            counter.maxNs.store(latencyNs, std::memory_order_relaxed);
+        auto& bucket = counter.buckets[BucketOf(latencyNs)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    std::vector<WamrExtSyscallStats> ExtSyscallStats::Collect() {
+        size_t syscallCount = m_gSyscallIDs.size();
+        std::vector<WamrExtSyscallStats> ret;
+        std::vector<uint64_t> buckets(BUCKET_COUNT);
+        std::lock_guard<std::mutex> _al(m_lock);
+        for (size_t i = 0; i < syscallCount; i++) {
+            WamrExtSyscallStats stats = {0};
+            stats.syscall_id = m_gSyscallIDs[i];
+            std::fill(buckets.begin(), buckets.end(), 0);
+            for (const auto& pBlock : m_threadBlocks) {
+                const auto& counter = pBlock->counters[i];
+                stats.call_count += counter.callCount.load(std::memory_order_relaxed);
+                stats.error_count += counter.errorCount.load(std::memory_order_relaxed);
+                stats.total_ns += counter.totalNs.load(std::memory_order_relaxed);
+                stats.max_ns = std::max(stats.max_ns, counter.maxNs.load(std::memory_order_relaxed));
+                for (uint32_t b = 0; b < BUCKET_COUNT; b++)
+                    buckets[b] += counter.buckets[b].load(std::memory_order_relaxed);
+            }
+            if (stats.call_count == 0)
+                continue;
+            // Counters are read while being updated, so percentiles are computed from the histogram total
+            uint64_t histTotal = 0;
+            for (uint64_t n : buckets)
+                histTotal += n;
+            struct {
+                uint64_t permille;
+                uint64_t* pResult;
+            } percentiles[] = {{500, &stats.p50_ns}, {900, &stats.p90_ns}, {990, &stats.p99_ns}};
+            uint64_t cumulative = 0;
+            size_t p = 0;
+            for (uint32_t b = 0; b < BUCKET_COUNT && p < sizeof(percentiles) / sizeof(percentiles[0]); b++) {
+                cumulative += buckets[b];
+                while (p < sizeof(percentiles) / sizeof(percentiles[0]) && cumulative * 1000 >= histTotal * percentiles[p].permille) {
+                    *percentiles[p].pResult = std::min(BucketUpperBound(b), stats.max_ns);
+                    p++;
+                }
+            }
+            ret.push_back(stats);
+        }
+        std::sort(ret.begin(), ret.end(), [](const WamrExtSyscallStats& a, const WamrExtSyscallStats& b) {
+            return a.syscall_id < b.syscall_id;
+        });
+        return ret;
+    }
+}
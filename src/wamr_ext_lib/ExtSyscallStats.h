@@ -0,0 +1,62 @@
+#pragma once
+#include "../base/BaseDef.h"
+#include <wamr_ext_api.h>
+
+namespace WAMR_EXT_NS {
+    // Call counts, error counts and latency histograms of ext syscalls made by an instance.
+    // Each thread records into its own block without locks, blocks are summed up when the stats are read.
+    class ExtSyscallStats {
+    public:
+        ExtSyscallStats() : m_id(m_gNextID.fetch_add(1, std::memory_order_relaxed)) {}
+        ExtSyscallStats(const ExtSyscallStats&) = delete;
+        ExtSyscallStats& operator=(const ExtSyscallStats&) = delete;
+
+        static bool IsEnabled() { return m_gEnabled.load(std::memory_order_relaxed); }
+        static void SetEnabled(bool bEnabled) { m_gEnabled.store(bEnabled, std::memory_order_relaxed); }
+        // Map syscall ID to the dense index used by Record(), it must be called before any instance is created
+        static uint32_t RegisterSyscall(uint32_t syscallID);
+
+        void Record(uint32_t syscallIndex, uint64_t latencyNs, bool bError);
+        // Stats of syscalls that have been called at least once, ordered by syscall ID
+        std::vector<WamrExtSyscallStats> Collect();
+    private:
+        // Log-linear buckets, values in [2^n, 2^(n+1)) are split into 2^SUB_BUCKET_BITS buckets
+        static constexpr uint32_t SUB_BUCKET_BITS = 2;
+        static constexpr uint32_t MAX_MAGNITUDE = 40;
+        static constexpr uint32_t BUCKET_COUNT = (MAX_MAGNITUDE - SUB_BUCKET_BITS + 2) << SUB_BUCKET_BITS;
+
+        // Written only by the owner thread, so plain loads and stores are enough
+        struct Counter {
+            std::atomic<uint64_t> callCount{0};
+            std::atomic<uint64_t> errorCount{0};
+            std::atomic<uint64_t> totalNs{0};
+            std::atomic<uint64_t> maxNs{0};
+            std::atomic<uint32_t> buckets[BUCKET_COUNT] = {};
+        };
+
+        struct ThreadBlock {
+            explicit ThreadBlock(size_t syscallCount) : counters(new Counter[syscallCount]) {}
+
+            std::unique_ptr<Counter[]> counters;
+            // Released when the owner thread exits, then the block is reused by another thread
+            std::atomic<bool> bOwned{true};
+        };
+
+        struct ThreadCacheEntry;
+        struct ThreadCache;
+
+        static uint32_t BucketOf(uint64_t value);
+        static uint64_t BucketUpperBound(uint32_t bucket);
+        ThreadBlock* GetThreadBlock();
+
+        static std::atomic<bool> m_gEnabled;
+        static std::atomic<uint64_t> m_gNextID;
+        static std::vector<uint32_t> m_gSyscallIDs;
+        static thread_local ThreadCache m_gThreadCache;
+
+        // Never reused, so that stale entries of the thread cache are not matched
+        const uint64_t m_id;
+        std::mutex m_lock;
+        std::vector<std::shared_ptr<ThreadBlock>> m_threadBlocks;
+    };
+}
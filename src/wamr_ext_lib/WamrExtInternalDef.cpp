@@ -1,10 +1,16 @@
 #include "WamrExtInternalDef.h"
 #include "../base/FSUtility.h"
 #include "uv.h"
+#include <wasm_runtime.h>
+#include <aot/aot_runtime.h>
 extern "C" {
 #include <fd_table.h>
 }
 
+WamrExtModuleCode::~WamrExtModuleCode() {
+    wasm_runtime_unload(wasmModule);
+}
+
 WamrExtInstanceConfig::WamrExtInstanceConfig() {
     auto tempDirPath = WAMR_EXT_NS::FSUtility::GetTempDir();
 #ifndef _WIN32
@@ -29,6 +35,53 @@ WamrExtInstanceConfig::WamrExtInstanceConfig() {
 namespace WAMR_EXT_NS {
     thread_local char gLastErrorStr[200] = {0};
 
+#ifdef OS_ENABLE_HW_BOUND_CHECK
+    // Signal handling of out of bounds accesses needs per-thread state, e.g. the alternate signal stack
+    struct WasmThreadEnv {
+        bool bInited{false};
+        ~WasmThreadEnv() {
+            if (bInited)
+                wasm_runtime_destroy_thread_env();
+        }
+    };
+    static thread_local WasmThreadEnv gWasmThreadEnv;
+#endif
+
+    void EnsureWasmThreadEnv() {
+#ifdef OS_ENABLE_HW_BOUND_CHECK
+        if (!gWasmThreadEnv.bInited && !wasm_runtime_thread_env_inited())
+            gWasmThreadEnv.bInited = wasm_runtime_init_thread_env();
+#endif
+    }
+
+    std::unordered_map<uint32_t, std::string> GetWasmFuncNames(wasm_module_t wasmModule) {
+        std::unordered_map<uint32_t, std::string> funcNames;
+        if (wasmModule->module_type == Wasm_Module_AoT) {
+            auto* pAOTModule = (AOTModule*)wasmModule;
+            for (uint32_t i = 0; i < pAOTModule->export_count; i++) {
+                if (pAOTModule->exports[i].kind == EXPORT_KIND_FUNC)
+                    funcNames.emplace(pAOTModule->exports[i].index, pAOTModule->exports[i].name);
+            }
+#if WASM_ENABLE_CUSTOM_NAME_SECTION != 0
+            for (uint32_t i = 0; i < pAOTModule->aux_func_name_count; i++)
+                funcNames[pAOTModule->aux_func_indexes[i]] = pAOTModule->aux_func_names[i];
+#endif
+        } else {
+            auto* pBytecodeModule = (WASMModule*)wasmModule;
+            for (uint32_t i = 0; i < pBytecodeModule->export_count; i++) {
+                if (pBytecodeModule->exports[i].kind == EXPORT_KIND_FUNC)
+                    funcNames.emplace(pBytecodeModule->exports[i].index, pBytecodeModule->exports[i].name);
+            }
+#if WASM_ENABLE_CUSTOM_NAME_SECTION != 0
+            for (uint32_t i = 0; i < pBytecodeModule->function_count; i++) {
+                if (pBytecodeModule->functions[i]->field_name)
+                    funcNames[pBytecodeModule->import_function_count + i] = pBytecodeModule->functions[i]->field_name;
+            }
+#endif
+        }
+        return funcNames;
+    }
+
     int32_t ExtSyscallBase::Invoke(wasm_exec_env_t pExecEnv, uint32_t argc, wasi::wamr_ext_syscall_arg *appArgv) {
         if (argc < m_argSig.length()) {
             assert(false);
@@ -1,33 +1,98 @@
 #pragma once
 #include "../base/BaseDef.h"
+#include "../base/EventNotifier.h"
+#include "../base/LoopThread.h"
+#include "../base/RingBufferAllocator.h"
+#include "../base/ShardedRegistry.h"
+#include "../base/SHA256.h"
 #include "WasiPthreadExt.h"
 #include "WasiProcessExt.h"
+#include "WasiChannelExt.h"
+#include "ExtSyscallStats.h"
 #include "wamr_ext_api.h"
+#include <deque>
 
 struct WamrExtInstanceConfig {
     std::map<std::string, std::string> preOpenDirs;     // mapped dir -> host dir
     std::map<std::string, std::string> envVars;
     std::map<std::string, std::string> hostCmdWhitelist;
+    std::map<std::string, uint32_t> channels;           // channel name -> capacity
     std::vector<std::string> args;
     uint32_t maxMemory{4194304 / WASM_PAGE_SIZE * WASM_PAGE_SIZE};
+    uint64_t maxCPUTime{0};     // microseconds, 0 means unlimited
+    uint32_t execTimeout{0};    // milliseconds, 0 means unlimited
+    uint32_t ioBufferSize{0};   // bytes, 0 means disabled
+    std::string pgoProfileFile;     // PGO profile data is dumped to it when the instance is destroyed
     WamrExtInstanceExceptionCB exceptionCB{.func = nullptr};
 
     WamrExtInstanceConfig();
 };
 
-struct WamrExtModule {
+struct WamrExtModule;
+
+// Exported function resolved once per module, instances cache their function instances by index
+struct WamrExtFunc {
+    WamrExtModule* pModule;
+    std::string name;
+    uint32_t index;
+    std::vector<wasm_valkind_t> paramTypes;
+    std::vector<wasm_valkind_t> resultTypes;
+    uint32_t paramCellCount{0};
+    uint32_t resultCellCount{0};
+};
+
+// Loaded wasm_module_t and the buffer it refers to
+struct WamrExtModuleCode {
+    // It may be the buffer of the cached AOT file compiled from the module content
     std::shared_ptr<uint8_t> pModuleBuf;
-    wasm_module_t wasmModule{nullptr};
+    uint32_t moduleBufLen;
+    wasm_module_t wasmModule;
+    bool bAOT;
+    // Set once the symbols of AOT functions are written to the perf map, guarded by gWasmLock
+    bool bPerfMapWritten{false};
+
+    explicit WamrExtModuleCode(const std::shared_ptr<uint8_t>& pBuf, uint32_t bufLen, wasm_module_t _wasmModule, bool _bAOT) :
+        pModuleBuf(pBuf), moduleBufLen(bufLen), wasmModule(_wasmModule), bAOT(_bAOT) {}
+    WamrExtModuleCode(const WamrExtModuleCode&) = delete;
+    WamrExtModuleCode& operator=(const WamrExtModuleCode&) = delete;
+    ~WamrExtModuleCode();
+};
+
+// Module shared by all WamrExtModules with the same content
+struct WamrExtModuleBody {
+    // Identity of the content, computed before the loader may rewrite the module buffer
+    WAMR_EXT_NS::SHA256::Digest contentDigest;
+    // Name of the module loading the content first, used to label the code in profilers
+    std::string name;
+    // Code loaded from the content or its cached AOT file
+    std::shared_ptr<WamrExtModuleCode> pCode;
+
+    explicit WamrExtModuleBody(const WAMR_EXT_NS::SHA256::Digest& digest, const char* _name, const std::shared_ptr<WamrExtModuleCode>& _pCode) :
+        contentDigest(digest), name(_name), pCode(_pCode) {}
+    WamrExtModuleBody(const WamrExtModuleBody&) = delete;
+    WamrExtModuleBody& operator=(const WamrExtModuleBody&) = delete;
+};
+
+struct WamrExtModule {
+    std::shared_ptr<WamrExtModuleBody> pBody;
     std::string moduleName;
     WamrExtInstanceConfig instDefaultConf;
+    std::mutex funcLock;
+    std::unordered_map<std::string, std::unique_ptr<WamrExtFunc>> funcMap;
 
-    explicit WamrExtModule(const std::shared_ptr<uint8_t>& pBuf, wasm_module_t _wasmModule, const char* name) :
-        pModuleBuf(pBuf), wasmModule(_wasmModule), moduleName(name) {}
+    explicit WamrExtModule(const std::shared_ptr<WamrExtModuleBody>& _pBody, const char* name) :
+        pBody(_pBody), moduleName(name) {}
     WamrExtModule(const WamrExtModule&) = delete;
     WamrExtModule& operator=(const WamrExtModule&) = delete;
 };
 
-struct WamrExtInstance {
+struct WamrExtAsyncCall {
+    std::string funcName;
+    std::vector<WamrExtValue> args;
+    WamrExtCallCompletionCB completionCB;
+};
+
+struct WamrExtInstance : public std::enable_shared_from_this<WamrExtInstance> {
     wamr_ext_instance_t* pUserCallbackPointer;
     std::mutex instanceLock;
     enum {
@@ -38,12 +103,34 @@ struct WamrExtInstance {
         STATE_DESTROYED,
     } state{STATE_NEW};
     WamrExtModule* pMainModule;
+    // Code which the main instance is instantiated from
+    std::shared_ptr<WamrExtModuleCode> pMainModuleCode;
     WamrExtInstanceConfig config;
     wasm_module_inst_t wasmMainInstance{nullptr};
     std::mutex execFuncLock;
     wasm_exec_env_t pMainExecEnv{nullptr};
+    // Indexed by WamrExtFunc::index, guarded by execFuncLock
+    std::vector<wasm_function_inst_t> funcInstCache;
+    // Guarded by instanceLock, used to match the execution timeout with the running function call
+    bool bExecuting{false};
+    uint64_t execSeq{0};
+    // Asynchronous calls in submission order, drained by at most one worker thread at a time, guarded by asyncCallLock
+    std::mutex asyncCallLock;
+    std::deque<WamrExtAsyncCall> asyncCallQueue;
+    bool bAsyncCallDraining{false};
+    // Set when the instance has been queued to be checked by its loop thread
+    std::atomic<bool> bCheckScheduled{false};
+    // Periodic check of the started instance, guarded by instanceLock
+    std::shared_ptr<WAMR_EXT_NS::TimerHandle> pCheckTimer;
+    // Ring buffer in app heap for request/response data exchanged with host, guarded by instanceLock
+    uint32_t ioBufferAppOffset{0};
+    std::unique_ptr<WAMR_EXT_NS::RingBufferAllocator> pIOBufferAllocator;
+    // Notified when the instance is terminated to interrupt blocking host calls
+    WAMR_EXT_NS::EventNotifier terminateNotifier;
     WAMR_EXT_NS::WasiPthreadExt::InstancePthreadManager wasiPthreadManager;
     WAMR_EXT_NS::WasiProcessExt::ProcManager wasiProcessManager;
+    WAMR_EXT_NS::WasiChannelExt::ChannelManager wasiChannelManager;
+    WAMR_EXT_NS::ExtSyscallStats syscallStats;
 
     explicit WamrExtInstance(WamrExtModule* _pModule, wamr_ext_instance_t* _pUserCallbackPointer) :
         pMainModule(_pModule), config(_pModule->instDefaultConf), pUserCallbackPointer(_pUserCallbackPointer) {}
@@ -58,6 +145,14 @@ struct WamrExtExceptionInfo {
 
 namespace WAMR_EXT_NS {
     extern thread_local char gLastErrorStr[200];
+    extern ShardedRegistry<WamrExtInstance> gAllInstances;
+
+    // Ask the loop thread of the instance to report the exception or release the instance
+    void ScheduleInstanceCheck(WamrExtInstance* pInst);
+    // Must be called before the current thread executes wasm code, it's required by HW bound check
+    void EnsureWasmThreadEnv();
+    // Function index -> name from the name section(if kept in the module) and exports
+    std::unordered_map<uint32_t, std::string> GetWasmFuncNames(wasm_module_t wasmModule);
 
     namespace wasi {
         union wamr_ext_syscall_arg {
@@ -100,6 +195,12 @@ namespace WAMR_EXT_NS {
             // Process ext
             __EXT_SYSCALL_PROC_SPAWN = 400,
             __EXT_SYSCALL_PROC_WAIT_PID = 401,
+
+            // Channel ext
+            __EXT_SYSCALL_CHANNEL_OPEN = 500,
+            __EXT_SYSCALL_CHANNEL_SEND = 501,
+            __EXT_SYSCALL_CHANNEL_RECV = 502,
+            __EXT_SYSCALL_CHANNEL_CLOSE = 503,
         };
 
         typedef long long wasi_time_t;
@@ -120,6 +221,9 @@ namespace WAMR_EXT_NS {
     public:
         ExtSyscallBase(const char* argSig, void* pFunc) : m_argSig(argSig), m_pFunc(pFunc) {}
         int32_t Invoke(wasm_exec_env_t pExecEnv, uint32_t argc, wasi::wamr_ext_syscall_arg* appArgv);
+
+        // Index of the syscall in ExtSyscallStats
+        uint32_t statsIndex{0};
     protected:
         virtual int32_t DoSyscall(wasm_exec_env_t pExecEnv, wasi::wamr_ext_syscall_arg* appArgv) = 0;
 
@@ -0,0 +1,144 @@
+#include "WamrExtProfiler.h"
+#include "WamrExtInternalDef.h"
+#include <wasm_runtime.h>
+#include <aot/aot_runtime.h>
+#include <algorithm>
+
+namespace WAMR_EXT_NS {
+    std::mutex WamrExtProfiler::m_gLock;
+    std::condition_variable WamrExtProfiler::m_gStopCond;
+    bool WamrExtProfiler::m_gbRunning = false;
+    std::thread WamrExtProfiler::m_gSampleThread;
+    std::map<std::string, WamrExtProfiler::ModuleSamples> WamrExtProfiler::m_gModuleSamples;
+
+    int32_t WamrExtProfiler::Start(uint32_t sampleHz) {
+        if (sampleHz == 0 || sampleHz > 10000)
+            return EINVAL;
+        std::lock_guard<std::mutex> _al(m_gLock);
+        if (m_gbRunning || m_gSampleThread.joinable())
+            return EALREADY;
+        m_gModuleSamples.clear();
+        m_gbRunning = true;
+        m_gSampleThread = std::thread(SampleRoutine, sampleHz);
+        return 0;
+    }
+
+    int32_t WamrExtProfiler::Stop() {
+        {
+            std::lock_guard<std::mutex> _al(m_gLock);
+            if (!m_gbRunning)
+                return 0;
+            m_gbRunning = false;
+        }
+        m_gStopCond.notify_all();
+        m_gSampleThread.join();
+        return 0;
+    }
+
+    int32_t WamrExtProfiler::Dump(const char* filePath) {
+        FILE* fp = fopen(filePath, "w");
+        if (!fp)
+            return errno;
+        std::lock_guard<std::mutex> _al(m_gLock);
+        for (const auto& moduleIt : m_gModuleSamples) {
+            auto funcNames = GetWasmFuncNames(moduleIt.second.pCode->wasmModule);
+            for (const auto& stackIt : moduleIt.second.stackCounts) {
+                std::string line = moduleIt.first;
+                for (uint32_t funcIndex : stackIt.first) {
+                    auto nameIt = funcNames.find(funcIndex);
+                    line += ';';
+                    line += nameIt != funcNames.end() ? nameIt->second : "func[" + std::to_string(funcIndex) + "]";
+                }
+                fprintf(fp, "%s %" PRIu64 "\n", line.c_str(), stackIt.second);
+            }
+        }
+        bool bWritten = fflush(fp) == 0;
+        fclose(fp);
+        return bWritten ? 0 : EIO;
+    }
+
+    void WamrExtProfiler::SampleRoutine(uint32_t sampleHz) {
+        Utility::SetCurrentThreadName("wamr_ext_prof");
+        auto interval = std::chrono::microseconds(1000000 / sampleHz);
+        auto nextSampleTime = std::chrono::steady_clock::now();
+        std::vector<std::vector<uint32_t>> stacks;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> _al(m_gLock);
+                nextSampleTime += interval;
+                if (m_gStopCond.wait_until(_al, nextSampleTime, []() { return !m_gbRunning; }))
+                    break;
+            }
+            // Sample without m_gLock held, so that dumping does not delay sampling
+            gAllInstances.ForEach([&stacks](const std::shared_ptr<WamrExtInstance>& pInst) {
+                stacks.clear();
+                SampleInstance(pInst.get(), stacks);
+                if (stacks.empty())
+                    return;
+                std::lock_guard<std::mutex> _al(m_gLock);
+                auto& moduleSamples = m_gModuleSamples[pInst->pMainModule->moduleName];
+                moduleSamples.pCode = pInst->pMainModuleCode;
+                for (auto& stack : stacks)
+                    moduleSamples.stackCounts[std::move(stack)]++;
+            });
+            // Skip missed samples instead of sampling in a burst
+            auto now = std::chrono::steady_clock::now();
+            if (nextSampleTime < now)
+                nextSampleTime = now;
+        }
+    }
+
+    void WamrExtProfiler::SampleInstance(WamrExtInstance* pInst, std::vector<std::vector<uint32_t>>& outStacks) {
+        // Exec envs are destroyed only after the instance leaves the started state
+        std::lock_guard<std::mutex> instAL(pInst->instanceLock);
+        if (pInst->state != WamrExtInstance::STATE_STARTED)
+            return;
+        WasiPthreadExt::ForEachExecEnv(&pInst->wasiPthreadManager, [&outStacks](wasm_exec_env_t pExecEnv) {
+            std::vector<uint32_t> stack;
+            WalkStack(pExecEnv, stack);
+            if (!stack.empty())
+                outStacks.push_back(std::move(stack));
+        });
+    }
+
+    // Frames are pushed and popped by the running thread while being walked here. Every field is read by a relaxed atomic
+    // load, so no read is torn, but the frames as a whole may be inconsistent, e.g. a frame being popped or a stale frame
+    // whose memory has been reused. Such a torn sample only records a wrong stack and is tolerated, each frame pointer is
+    // checked to be an aligned frame inside the wasm stack and each function to be one of the instance, so the walk never
+    // leaves the stack and stops after MAX_STACK_DEPTH frames.
+    template<typename T>
+    static inline T LoadFrameField(const T& field) {
+        return __atomic_load_n(&field, __ATOMIC_RELAXED);
+    }
+
+    void WamrExtProfiler::WalkStack(wasm_exec_env_t pExecEnv, std::vector<uint32_t>& outStack) {
+        auto* pStackBottom = pExecEnv->wasm_stack.s.bottom;
+        auto* pStackTop = pExecEnv->wasm_stack.s.top_boundary;
+        auto bFrameInStack = [pStackBottom, pStackTop](const void* p, size_t frameSize) {
+            return ((uintptr_t)p & (alignof(void*) - 1)) == 0 && (const uint8_t*)p >= pStackBottom &&
+                   (const uint8_t*)p <= pStackTop - frameSize;
+        };
+        auto* pWasmInst = get_module_inst(pExecEnv);
+        void* pFrame = LoadFrameField(*(void**)&pExecEnv->cur_frame);
+        if (pWasmInst->module_type == Wasm_Module_AoT) {
+            while (pFrame && bFrameInStack(pFrame, sizeof(AOTFrame)) && outStack.size() < MAX_STACK_DEPTH) {
+                auto* pAOTFrame = (AOTFrame*)pFrame;
+                outStack.push_back(LoadFrameField(pAOTFrame->func_index));
+                pFrame = LoadFrameField(*(void**)&pAOTFrame->prev_frame);
+            }
+        } else {
+            auto* pExtra = ((WASMModuleInstance*)pWasmInst)->e;
+            uintptr_t funcsBegin = (uintptr_t)pExtra->functions;
+            uintptr_t funcsEnd = funcsBegin + pExtra->function_count * sizeof(WASMFunctionInstance);
+            while (pFrame && bFrameInStack(pFrame, sizeof(WASMInterpFrame)) && outStack.size() < MAX_STACK_DEPTH) {
+                auto* pInterpFrame = (WASMInterpFrame*)pFrame;
+                // Frames without function are pushed for calls from host
+                auto func = (uintptr_t)LoadFrameField(pInterpFrame->function);
+                if (func >= funcsBegin && func < funcsEnd && (func - funcsBegin) % sizeof(WASMFunctionInstance) == 0)
+                    outStack.push_back((func - funcsBegin) / sizeof(WASMFunctionInstance));
+                pFrame = LoadFrameField(*(void**)&pInterpFrame->prev_frame);
+            }
+        }
+        std::reverse(outStack.begin(), outStack.end());
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "../base/BaseDef.h"
+#include <condition_variable>
+#include <thread>
+
+struct WamrExtInstance;
+struct WamrExtModuleCode;
+
+namespace WAMR_EXT_NS {
+    // Sample wasm call stacks of all started instances periodically from a background thread.
+    // Frames are read from the wasm stacks of exec envs, AOT code has frames only if compiled with wamrc --enable-dump-call-stack.
+    // Threads are not stopped for sampling, a sample taken while frames are being pushed or popped may have a wrong stack.
+    class WamrExtProfiler {
+    public:
+        // Samples collected before are cleared
+        static int32_t Start(uint32_t sampleHz);
+        static int32_t Stop();
+        // Write samples in collapsed stack format("<module>;<root func>;...;<leaf func> <count>" per line)
+        static int32_t Dump(const char* filePath);
+    private:
+        struct ModuleSamples {
+            // Keep the code alive to resolve function names when dumping
+            std::shared_ptr<WamrExtModuleCode> pCode;
+            // Function indexes from the root -> sample count
+            std::map<std::vector<uint32_t>, uint64_t> stackCounts;
+        };
+
+        static constexpr uint32_t MAX_STACK_DEPTH = 128;
+
+        static void SampleRoutine(uint32_t sampleHz);
+        static void SampleInstance(WamrExtInstance* pInst, std::vector<std::vector<uint32_t>>& outStacks);
+        static void WalkStack(wasm_exec_env_t pExecEnv, std::vector<uint32_t>& outStack);
+
+        static std::mutex m_gLock;
+        static std::condition_variable m_gStopCond;
+        static bool m_gbRunning;
+        static std::thread m_gSampleThread;
+        // Module name -> samples, guarded by m_gLock
+        static std::map<std::string, ModuleSamples> m_gModuleSamples;
+    };
+}
@@ -0,0 +1,283 @@
+#include "WasiChannelExt.h"
+#include "WamrExtInternalDef.h"
+#include <algorithm>
+
+namespace WAMR_EXT_NS {
+    namespace wasi {
+        struct wamr_channel_open_req {
+            uint32_t app_name_pointer;
+            uint32_t ret_handle;
+        };
+
+        static_assert(std::is_trivial<wamr_channel_open_req>::value);
+
+        struct wamr_channel_io_req {
+            uint32_t handle;
+            uint32_t app_buf_offset;
+            uint32_t buf_len;
+            int32_t timeout_ms;     // -1 means infinite
+            uint32_t ret_size;
+        };
+
+        static_assert(std::is_trivial<wamr_channel_io_req>::value);
+    }
+
+#define CHANNEL_MSG_HEADER_SIZE sizeof(uint32_t)
+#define CHANNEL_MSG_ALIGNMENT 4
+
+    std::mutex WasiChannelExt::m_gChannelMapLock;
+    std::unordered_map<std::string, std::weak_ptr<WasiChannelExt::Channel>> WasiChannelExt::m_gChannelMap;
+
+    void WasiChannelExt::Init() {
+        RegisterExtSyscall(wasi::__EXT_SYSCALL_CHANNEL_OPEN, std::make_shared<ExtSyscall_P>((void*)ChannelOpen));
+        RegisterExtSyscall(wasi::__EXT_SYSCALL_CHANNEL_SEND, std::make_shared<ExtSyscall_P>((void*)ChannelSend));
+        RegisterExtSyscall(wasi::__EXT_SYSCALL_CHANNEL_RECV, std::make_shared<ExtSyscall_P>((void*)ChannelRecv));
+        RegisterExtSyscall(wasi::__EXT_SYSCALL_CHANNEL_CLOSE, std::make_shared<ExtSyscall_U32>((void*)ChannelClose));
+    }
+
+    void WasiChannelExt::Channel::CopyIn(uint64_t pos, const void* pData, uint32_t size) {
+        uint32_t offset = pos % m_ringBuf.size();
+        uint32_t firstPartSize = std::min<uint32_t>(size, m_ringBuf.size() - offset);
+        memcpy(m_ringBuf.data() + offset, pData, firstPartSize);
+        if (firstPartSize < size)
+            memcpy(m_ringBuf.data(), static_cast<const uint8_t*>(pData) + firstPartSize, size - firstPartSize);
+    }
+
+    void WasiChannelExt::Channel::CopyOut(uint64_t pos, void* pBuf, uint32_t size) {
+        uint32_t offset = pos % m_ringBuf.size();
+        uint32_t firstPartSize = std::min<uint32_t>(size, m_ringBuf.size() - offset);
+        memcpy(pBuf, m_ringBuf.data() + offset, firstPartSize);
+        if (firstPartSize < size)
+            memcpy(static_cast<uint8_t*>(pBuf) + firstPartSize, m_ringBuf.data(), size - firstPartSize);
+    }
+
+    uvwasi_errno_t WasiChannelExt::Channel::TrySend(const uint8_t* pData, uint32_t size) {
+        uint64_t totalSize = ((uint64_t)CHANNEL_MSG_HEADER_SIZE + size + CHANNEL_MSG_ALIGNMENT - 1) & ~(uint64_t)(CHANNEL_MSG_ALIGNMENT - 1);
+        if (totalSize > m_ringBuf.size())
+            return UVWASI_EMSGSIZE;
+        {
+            std::lock_guard<std::mutex> _al(m_lock);
+            if (m_writePos == m_readPos && !m_receivers.empty() && m_receivers.front()->bufSize >= size) {
+                // Copy into the buffer of the receiver without going through the ring buffer
+                Receiver* pReceiver = m_receivers.front();
+                m_receivers.pop_front();
+                memcpy(pReceiver->pBuf, pData, size);
+                pReceiver->msgSize = size;
+                pReceiver->bRegistered = false;
+                pReceiver->bReceived = true;
+            } else {
+                if (m_ringBuf.size() - (m_writePos - m_readPos) < totalSize)
+                    return UVWASI_EAGAIN;
+                CopyIn(m_writePos, &size, CHANNEL_MSG_HEADER_SIZE);
+                CopyIn(m_writePos + CHANNEL_MSG_HEADER_SIZE, pData, size);
+                m_writePos += totalSize;
+            }
+            m_dataSeq.fetch_add(1);
+        }
+        if (m_dataWaiterCount.load() > 0)
+            Utility::FutexWakeAll(m_dataSeq);
+        return 0;
+    }
+
+    uvwasi_errno_t WasiChannelExt::Channel::TryRecv(Receiver& receiver, bool bWait) {
+        {
+            std::lock_guard<std::mutex> _al(m_lock);
+            if (receiver.bReceived)
+                return 0;
+            if (m_writePos == m_readPos) {
+                if (bWait && !receiver.bRegistered) {
+                    m_receivers.push_back(&receiver);
+                    receiver.bRegistered = true;
+                }
+                return UVWASI_EAGAIN;
+            }
+            if (receiver.bRegistered) {
+                m_receivers.erase(std::find(m_receivers.begin(), m_receivers.end(), &receiver));
+                receiver.bRegistered = false;
+            }
+            CopyOut(m_readPos, &receiver.msgSize, CHANNEL_MSG_HEADER_SIZE);
+            if (receiver.msgSize > receiver.bufSize)
+                return UVWASI_EMSGSIZE;
+            CopyOut(m_readPos + CHANNEL_MSG_HEADER_SIZE, receiver.pBuf, receiver.msgSize);
+            m_readPos += ((uint64_t)CHANNEL_MSG_HEADER_SIZE + receiver.msgSize + CHANNEL_MSG_ALIGNMENT - 1) & ~(uint64_t)(CHANNEL_MSG_ALIGNMENT - 1);
+            m_spaceSeq.fetch_add(1);
+        }
+        if (m_spaceWaiterCount.load() > 0)
+            Utility::FutexWakeAll(m_spaceSeq);
+        return 0;
+    }
+
+    bool WasiChannelExt::Channel::CancelRecv(Receiver& receiver) {
+        std::lock_guard<std::mutex> _al(m_lock);
+        if (receiver.bRegistered) {
+            m_receivers.erase(std::find(m_receivers.begin(), m_receivers.end(), &receiver));
+            receiver.bRegistered = false;
+        }
+        return receiver.bReceived;
+    }
+
+    std::shared_ptr<WasiChannelExt::Channel> WasiChannelExt::GetChannel(WamrExtInstance* pInst, uint32_t handle) {
+        auto* pManager = &pInst->wasiChannelManager;
+        std::lock_guard<std::mutex> _al(pManager->lock);
+        auto it = pManager->channelMap.find(handle);
+        return it != pManager->channelMap.end() ? it->second : nullptr;
+    }
+
+    uvwasi_errno_t WasiChannelExt::WaitChannelSeq(WamrExtInstance* pInst, std::atomic<uint32_t>& seq, std::atomic<uint32_t>& waiterCount,
+                                                  uint32_t observedSeq, const std::chrono::steady_clock::time_point& deadline) {
+        uint64_t waitNs = UINT64_MAX;
+        if (deadline != std::chrono::steady_clock::time_point::max()) {
+            auto now = std::chrono::steady_clock::now();
+            if (now >= deadline)
+                return UVWASI_EAGAIN;
+            waitNs = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - now).count();
+        }
+        waiterCount.fetch_add(1);
+        // WakeUpWaiters() bumps the sequence after setting the notifier, so either the notifier is seen here
+        // or the futex wait returns immediately
+        uvwasi_errno_t err = 0;
+        if (pInst->terminateNotifier.IsNotified())
+            err = UVWASI_EINTR;
+        else
+            Utility::FutexWait(seq, observedSeq, waitNs);
+        waiterCount.fetch_sub(1);
+        return err;
+    }
+
+    void WasiChannelExt::WakeUpWaiters(ChannelManager& manager) {
+        std::lock_guard<std::mutex> _al(manager.lock);
+        for (auto& it : manager.channelMap) {
+            auto& pChannel = it.second;
+            pChannel->m_dataSeq.fetch_add(1);
+            Utility::FutexWakeAll(pChannel->m_dataSeq);
+            pChannel->m_spaceSeq.fetch_add(1);
+            Utility::FutexWakeAll(pChannel->m_spaceSeq);
+        }
+    }
+
+    int32_t WasiChannelExt::ChannelOpen(wasm_exec_env_t pExecEnv, void* _pAppReq) {
+        wasm_module_inst_t pWasmModuleInst = get_module_inst(pExecEnv);
+        auto* pWamrExtInst = (WamrExtInstance*)wasm_runtime_get_custom_data(pWasmModuleInst);
+        if (!wasm_runtime_validate_native_addr(pWasmModuleInst, _pAppReq, sizeof(wasi::wamr_channel_open_req)))
+            return UVWASI_EFAULT;
+        auto* pAppReq = static_cast<wasi::wamr_channel_open_req*>(_pAppReq);
+        if (!wasm_runtime_validate_app_str_addr(pWasmModuleInst, pAppReq->app_name_pointer))
+            return UVWASI_EFAULT;
+        std::string channelName = static_cast<const char*>(wasm_runtime_addr_app_to_native(pWasmModuleInst, pAppReq->app_name_pointer));
+        uint32_t capacity = 0;
+        {
+            std::lock_guard<std::mutex> _instAL(pWamrExtInst->instanceLock);
+            auto it = pWamrExtInst->config.channels.find(channelName);
+            if (it == pWamrExtInst->config.channels.end())
+                return UVWASI_EACCES;
+            capacity = it->second;
+        }
+        std::shared_ptr<Channel> pChannel;
+        {
+            std::lock_guard<std::mutex> _al(m_gChannelMapLock);
+            auto& pWeakChannel = m_gChannelMap[channelName];
+            pChannel = pWeakChannel.lock();
+            if (!pChannel) {
+                // The first opener decides the capacity
+                pChannel = std::make_shared<Channel>(capacity);
+                pWeakChannel = pChannel;
+            }
+            // Drop entries of channels closed by all instances
+            for (auto it = m_gChannelMap.begin(); it != m_gChannelMap.end();) {
+                if (it->second.expired())
+                    it = m_gChannelMap.erase(it);
+                else
+                    it++;
+            }
+        }
+        auto* pManager = &pWamrExtInst->wasiChannelManager;
+        std::lock_guard<std::mutex> _al(pManager->lock);
+        uint32_t handle = pManager->nextHandle++;
+        pManager->channelMap[handle] = std::move(pChannel);
+        pAppReq->ret_handle = handle;
+        return 0;
+    }
+
+    int32_t WasiChannelExt::ChannelSend(wasm_exec_env_t pExecEnv, void* _pAppReq) {
+        wasm_module_inst_t pWasmModuleInst = get_module_inst(pExecEnv);
+        auto* pWamrExtInst = (WamrExtInstance*)wasm_runtime_get_custom_data(pWasmModuleInst);
+        if (!wasm_runtime_validate_native_addr(pWasmModuleInst, _pAppReq, sizeof(wasi::wamr_channel_io_req)))
+            return UVWASI_EFAULT;
+        auto* pAppReq = static_cast<wasi::wamr_channel_io_req*>(_pAppReq);
+        if (pAppReq->buf_len > 0 && !wasm_runtime_validate_app_addr(pWasmModuleInst, pAppReq->app_buf_offset, pAppReq->buf_len))
+            return UVWASI_EFAULT;
+        auto pChannel = GetChannel(pWamrExtInst, pAppReq->handle);
+        if (!pChannel)
+            return UVWASI_EBADF;
+        auto deadline = pAppReq->timeout_ms < 0 ? std::chrono::steady_clock::time_point::max() :
+                        std::chrono::steady_clock::now() + std::chrono::milliseconds(pAppReq->timeout_ms);
+        while (true) {
+            uint32_t observedSeq = pChannel->m_spaceSeq.load();
+            // The linear memory may be moved after growing, so always get the native address again
+            auto* pData = static_cast<const uint8_t*>(wasm_runtime_addr_app_to_native(pWasmModuleInst, pAppReq->app_buf_offset));
+            uvwasi_errno_t err = pChannel->TrySend(pData, pAppReq->buf_len);
+            if (err == 0) {
+                pAppReq->ret_size = pAppReq->buf_len;
+                return 0;
+            } else if (err != UVWASI_EAGAIN || pAppReq->timeout_ms == 0) {
+                return err;
+            }
+            if ((err = WaitChannelSeq(pWamrExtInst, pChannel->m_spaceSeq, pChannel->m_spaceWaiterCount, observedSeq, deadline)) != 0)
+                return err;
+        }
+    }
+
+    int32_t WasiChannelExt::ChannelRecv(wasm_exec_env_t pExecEnv, void* _pAppReq) {
+        wasm_module_inst_t pWasmModuleInst = get_module_inst(pExecEnv);
+        auto* pWamrExtInst = (WamrExtInstance*)wasm_runtime_get_custom_data(pWasmModuleInst);
+        if (!wasm_runtime_validate_native_addr(pWasmModuleInst, _pAppReq, sizeof(wasi::wamr_channel_io_req)))
+            return UVWASI_EFAULT;
+        auto* pAppReq = static_cast<wasi::wamr_channel_io_req*>(_pAppReq);
+        if (pAppReq->buf_len > 0 && !wasm_runtime_validate_app_addr(pWasmModuleInst, pAppReq->app_buf_offset, pAppReq->buf_len))
+            return UVWASI_EFAULT;
+        auto pChannel = GetChannel(pWamrExtInst, pAppReq->handle);
+        if (!pChannel)
+            return UVWASI_EBADF;
+        auto deadline = pAppReq->timeout_ms < 0 ? std::chrono::steady_clock::time_point::max() :
+                        std::chrono::steady_clock::now() + std::chrono::milliseconds(pAppReq->timeout_ms);
+        // Only this thread may grow a non-shared linear memory and a shared one is never moved, so the native buffer
+        // stays valid while senders may copy into it
+        Channel::Receiver receiver;
+        receiver.pBuf = static_cast<uint8_t*>(wasm_runtime_addr_app_to_native(pWasmModuleInst, pAppReq->app_buf_offset));
+        receiver.bufSize = pAppReq->buf_len;
+        while (true) {
+            uint32_t observedSeq = pChannel->m_dataSeq.load();
+            uvwasi_errno_t err = pChannel->TryRecv(receiver, pAppReq->timeout_ms != 0);
+            if (err == 0 || err == UVWASI_EMSGSIZE) {
+                // Report the required size if the buffer is too small, the message is kept in the channel
+                pAppReq->ret_size = receiver.msgSize;
+                return err;
+            } else if (err != UVWASI_EAGAIN || pAppReq->timeout_ms == 0) {
+                return err;
+            }
+            if ((err = WaitChannelSeq(pWamrExtInst, pChannel->m_dataSeq, pChannel->m_dataWaiterCount, observedSeq, deadline)) != 0) {
+                // A sender may have copied a message in before the receiver is unregistered
+                if (pChannel->CancelRecv(receiver)) {
+                    pAppReq->ret_size = receiver.msgSize;
+                    return 0;
+                }
+                return err;
+            }
+        }
+    }
+
+    int32_t WasiChannelExt::ChannelClose(wasm_exec_env_t pExecEnv, uint32_t handle) {
+        auto* pWamrExtInst = (WamrExtInstance*)wasm_runtime_get_custom_data(get_module_inst(pExecEnv));
+        auto* pManager = &pWamrExtInst->wasiChannelManager;
+        std::shared_ptr<Channel> pChannel;
+        {
+            std::lock_guard<std::mutex> _al(pManager->lock);
+            auto it = pManager->channelMap.find(handle);
+            if (it == pManager->channelMap.end())
+                return UVWASI_EBADF;
+            pChannel = std::move(it->second);
+            pManager->channelMap.erase(it);
+        }
+        return 0;
+    }
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include "../base/Utility.h"
+#include <deque>
+
+struct WamrExtInstance;
+
+namespace WAMR_EXT_NS {
+    class WasiChannelExt {
+    public:
+        // Message queue shared by instances. A message is copied from the sender into the buffer of a waiting receiver directly,
+        // or queued in a host ring buffer if no receiver is waiting.
+        class Channel {
+        public:
+            // Receive request of a blocked receiver, guarded by the channel lock once registered
+            struct Receiver {
+                uint8_t* pBuf;
+                uint32_t bufSize;
+                uint32_t msgSize{0};
+                bool bRegistered{false};
+                bool bReceived{false};
+            };
+
+            explicit Channel(uint32_t capacity) : m_ringBuf(capacity) {}
+            Channel(const Channel&) = delete;
+            Channel& operator=(const Channel&) = delete;
+
+            // Return UVWASI_EAGAIN if the channel is full, or UVWASI_EMSGSIZE if the message can never fit
+            uvwasi_errno_t TrySend(const uint8_t* pData, uint32_t size);
+            // Return UVWASI_EAGAIN if the channel is empty, or UVWASI_EMSGSIZE with the message size if the buffer is too small.
+            // With bWait, the receiver is registered on the empty channel so that senders copy the next message into its buffer,
+            // it must be received or cancelled by CancelRecv() then.
+            uvwasi_errno_t TryRecv(Receiver& receiver, bool bWait);
+            // Unregister the receiver, return true if a message has been copied into its buffer
+            bool CancelRecv(Receiver& receiver);
+        private:
+            friend class WasiChannelExt;
+
+            void CopyIn(uint64_t pos, const void* pData, uint32_t size);
+            void CopyOut(uint64_t pos, void* pBuf, uint32_t size);
+
+            std::mutex m_lock;
+            std::vector<uint8_t> m_ringBuf;
+            uint64_t m_readPos{0};
+            uint64_t m_writePos{0};
+            // Registered only while the ring buffer is empty, served in FIFO order
+            std::deque<Receiver*> m_receivers;
+            // Sequence words bumped after sending/receiving messages, waiters block on them by futex
+            std::atomic<uint32_t> m_dataSeq{0};
+            std::atomic<uint32_t> m_spaceSeq{0};
+            std::atomic<uint32_t> m_dataWaiterCount{0};
+            std::atomic<uint32_t> m_spaceWaiterCount{0};
+        };
+
+        class ChannelManager {
+        public:
+            ChannelManager() = default;
+            ChannelManager(const ChannelManager&) = delete;
+            ChannelManager& operator=(const ChannelManager&) = delete;
+            friend class WasiChannelExt;
+        private:
+            std::mutex lock;
+            uint32_t nextHandle{1};
+            std::unordered_map<uint32_t, std::shared_ptr<Channel>> channelMap;
+        };
+
+        static void Init();
+        // Wake up threads of the instance blocked in channels, called after the terminate notifier of the instance is set
+        static void WakeUpWaiters(ChannelManager& manager);
+    private:
+        static std::mutex m_gChannelMapLock;
+        static std::unordered_map<std::string, std::weak_ptr<Channel>> m_gChannelMap;
+
+        static std::shared_ptr<Channel> GetChannel(WamrExtInstance* pInst, uint32_t handle);
+        static uvwasi_errno_t WaitChannelSeq(WamrExtInstance* pInst, std::atomic<uint32_t>& seq, std::atomic<uint32_t>& waiterCount,
+                                             uint32_t observedSeq, const std::chrono::steady_clock::time_point& deadline);
+
+        static int32_t ChannelOpen(wasm_exec_env_t pExecEnv, void* _pAppReq);
+        static int32_t ChannelSend(wasm_exec_env_t pExecEnv, void* _pAppReq);
+        static int32_t ChannelRecv(wasm_exec_env_t pExecEnv, void* _pAppReq);
+        static int32_t ChannelClose(wasm_exec_env_t pExecEnv, uint32_t handle);
+    };
+}
@@ -191,6 +191,9 @@ namespace WAMR_EXT_NS {
                     }
                 }
             }
+            // The last poll FD is used to wake up when the instance is terminated
+            procPollFDs.emplace_back();
+            procPollFDs.back().fd = pWamrExtInst->terminateNotifier.GetPollFD();
             for (auto& pollFD : procPollFDs) {
                 pollFD.revents = 0;
                 pollFD.events = POLLIN;
@@ -199,6 +202,9 @@ namespace WAMR_EXT_NS {
             if (opt & __WASI_WNOHANG)
                 timeout = 0;
             int pollret = poll(procPollFDs.data(), procPollFDs.size(), timeout);
+            if (pollret > 0 && procPollFDs.back().revents)
+                return UVWASI_EINTR;
+            procPollFDs.pop_back();
             if (pollret == -1) {
                 err = errno;
                 break;
@@ -9,6 +9,10 @@ namespace WAMR_EXT_NS {
             ProcManager() = default;
             ProcManager(const ProcManager&) = delete;
             ProcManager& operator=(const ProcManager&) = delete;
+            size_t GetChildProcCount() {
+                std::lock_guard<std::mutex> _al(lock);
+                return childProcMap.size();
+            }
             friend class WasiProcessExt;
         private:
             struct ChildProcInfo {
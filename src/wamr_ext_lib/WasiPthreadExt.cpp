@@ -31,31 +31,97 @@ namespace WAMR_EXT_NS {
         auto& pThreadInfo = pManager->m_threadMap[PTHREAD_EXT_MAIN_THREAD_ID];
         pThreadInfo.reset(new InstancePthreadManager::ExecEnvThreadInfo({pMainExecEnv, [](wasm_exec_env_t){}}));
         pThreadInfo->handleID = PTHREAD_EXT_MAIN_THREAD_ID;
-        pThreadInfo->exitCtrl.waitCount = -1;
     }
 
     void WasiPthreadExt::CleanupAppThreadInfo(wasm_exec_env_t pMainExecEnv) {
         auto* pManager = GetInstPthreadManager(pMainExecEnv);
-        while (true) {
-            std::vector<std::shared_ptr<InstancePthreadManager::ExecEnvThreadInfo>> allThreadInfo;
-            {
-                std::lock_guard<std::mutex> _al(pManager->m_threadMapLock);
-                for (const auto& it : pManager->m_threadMap) {
-                    if (it.second->handleID != PTHREAD_EXT_MAIN_THREAD_ID)
-                        allThreadInfo.push_back(it.second);
-                }
+        {
+            std::lock_guard<std::mutex> _al(pManager->m_threadMapLock);
+            // No more app threads can be spawned from now on, so cancelling all threads once is enough
+            pManager->m_bExiting = true;
+            for (const auto& it : pManager->m_threadMap) {
+                if (it.second->handleID != PTHREAD_EXT_MAIN_THREAD_ID)
+                    CancelAppThread(it.second->pExecEnv.get());
             }
-            if (allThreadInfo.empty())
-                break;
-            for (const auto& pThreadInfo : allThreadInfo)
-                CancelAppThread(pThreadInfo->pExecEnv.get());
-            for (const auto& pThreadInfo : allThreadInfo)
-                DoHostThreadJoin(pManager, pThreadInfo);
         }
+        DoAllHostThreadsJoin(pManager);
         DoAppThreadExit(pMainExecEnv);
         assert(pManager->m_threadMap.size() == 1);
     }
 
+    void WasiPthreadExt::TerminateAppThreads(wasm_exec_env_t pMainExecEnv, const char* exception) {
+        auto* pManager = GetInstPthreadManager(pMainExecEnv);
+        std::lock_guard<std::mutex> _al(pManager->m_threadMapLock);
+        for (const auto& it : pManager->m_threadMap) {
+            auto* pExecEnv = it.second->pExecEnv.get();
+            if (exception)
+                wasm_runtime_set_exception(get_module_inst(pExecEnv), exception);
+            CancelAppThread(pExecEnv);
+        }
+    }
+
+    void WasiPthreadExt::ForEachExecEnv(InstancePthreadManager* pManager, const std::function<void(wasm_exec_env_t)>& func) {
+        std::lock_guard<std::mutex> _al(pManager->m_threadMapLock);
+        for (const auto& it : pManager->m_threadMap) {
+            if (it.second->exitState.load(std::memory_order_acquire) != InstancePthreadManager::ExecEnvThreadInfo::EXIT_STATE_EXITED)
+                func(it.second->pExecEnv.get());
+        }
+    }
+
+    void WasiPthreadExt::BeginCPUTimeAccounting(wasm_exec_env_t pExecEnv) {
+        auto* pThreadInfo = GetExecEnvThreadInfo(pExecEnv);
+        if (!pThreadInfo)
+            return;
+        std::lock_guard<std::mutex> _al(pThreadInfo->cpuTime.lock);
+#ifndef _WIN32
+        // The exec env of the main thread may be run by different host threads
+        if (pthread_getcpuclockid(pthread_self(), &pThreadInfo->cpuTime.clockID) != 0)
+            pThreadInfo->cpuTime.clockID = CLOCK_THREAD_CPUTIME_ID;
+#endif
+        pThreadInfo->cpuTime.bAccounting = true;
+        pThreadInfo->cpuTime.sampleNs = Utility::GetCurrentThreadCPUTimeNs();
+    }
+
+    void WasiPthreadExt::UpdateCPUTimeUsage(wasm_exec_env_t pExecEnv) {
+        auto* pThreadInfo = GetExecEnvThreadInfo(pExecEnv);
+        if (!pThreadInfo)
+            return;
+        std::lock_guard<std::mutex> _al(pThreadInfo->cpuTime.lock);
+        AccumulateCPUTimeUsage(GetInstPthreadManager(pExecEnv), pThreadInfo, Utility::GetCurrentThreadCPUTimeNs());
+    }
+
+    void WasiPthreadExt::EndCPUTimeAccounting(wasm_exec_env_t pExecEnv) {
+        auto* pThreadInfo = GetExecEnvThreadInfo(pExecEnv);
+        if (!pThreadInfo)
+            return;
+        std::lock_guard<std::mutex> _al(pThreadInfo->cpuTime.lock);
+        AccumulateCPUTimeUsage(GetInstPthreadManager(pExecEnv), pThreadInfo, Utility::GetCurrentThreadCPUTimeNs());
+        pThreadInfo->cpuTime.bAccounting = false;
+    }
+
+    void WasiPthreadExt::SampleCPUTimeUsage(InstancePthreadManager* pManager) {
+#ifndef _WIN32
+        std::lock_guard<std::mutex> _al(pManager->m_threadMapLock);
+        for (const auto& it : pManager->m_threadMap) {
+            auto* pThreadInfo = it.second.get();
+            std::lock_guard<std::mutex> cpuTimeAL(pThreadInfo->cpuTime.lock);
+            // The host thread is alive until it ends accounting
+            if (pThreadInfo->cpuTime.bAccounting)
+                AccumulateCPUTimeUsage(pManager, pThreadInfo, Utility::GetThreadCPUTimeNs(pThreadInfo->cpuTime.clockID));
+        }
+#endif
+    }
+
+    void WasiPthreadExt::AccumulateCPUTimeUsage(InstancePthreadManager* pManager, InstancePthreadManager::ExecEnvThreadInfo* pThreadInfo,
+                                                uint64_t curCPUTimeNs) {
+        if (!pThreadInfo->cpuTime.bAccounting)
+            return;
+        if (curCPUTimeNs > pThreadInfo->cpuTime.sampleNs) {
+            pManager->m_cpuTimeUsageNs.fetch_add(curCPUTimeNs - pThreadInfo->cpuTime.sampleNs, std::memory_order_relaxed);
+            pThreadInfo->cpuTime.sampleNs = curCPUTimeNs;
+        }
+    }
+
     WasiPthreadExt::InstancePthreadManager::ExecEnvThreadInfo *WasiPthreadExt::GetExecEnvThreadInfo(wasm_exec_env_t pExecEnv) {
         return (WasiPthreadExt::InstancePthreadManager::ExecEnvThreadInfo*)wasm_runtime_get_user_data(pExecEnv);
     }
@@ -65,27 +131,41 @@ namespace WAMR_EXT_NS {
         return &pWamrExtInst->wasiPthreadManager;
     }
 
-    void WasiPthreadExt::DoHostThreadJoin(InstancePthreadManager* pManager, const std::shared_ptr<InstancePthreadManager::ExecEnvThreadInfo> &pThreadInfo) {
-        bool bDelThreadInfo = false;
-        do {
-            std::unique_lock al(pThreadInfo->exitCtrl.exitLock);
-            if (pThreadInfo->exitCtrl.waitCount < 0) {
-                // Thread exited or detached
-                bDelThreadInfo = true;
+    void WasiPthreadExt::DoAllHostThreadsJoin(InstancePthreadManager* pManager) {
+        while (true) {
+            uint32_t runningCount = pManager->m_runningThreadCount.load();
+            if (runningCount == 0)
                 break;
+            Utility::FutexWait(pManager->m_runningThreadCount, runningCount);
+        }
+        std::vector<std::shared_ptr<InstancePthreadManager::ExecEnvThreadInfo>> exitedThreadInfo;
+        {
+            std::lock_guard<std::mutex> _al(pManager->m_threadMapLock);
+            for (auto it = pManager->m_threadMap.begin(); it != pManager->m_threadMap.end();) {
+                if (it->second->handleID != PTHREAD_EXT_MAIN_THREAD_ID) {
+                    exitedThreadInfo.push_back(std::move(it->second));
+                    it = pManager->m_threadMap.erase(it);
+                } else {
+                    it++;
+                }
             }
-            pThreadInfo->exitCtrl.waitCount++;
-            pThreadInfo->exitCtrl.exitCV.wait(al);
-            pThreadInfo->exitCtrl.waitCount--;
-            if (pThreadInfo->exitCtrl.waitCount == 0) {
-                pThreadInfo->pHostThread->join();
-                pThreadInfo->exitCtrl.waitCount = -1;
-                bDelThreadInfo = true;
-            }
-        } while (false);
-        if (bDelThreadInfo) {
+        }
+        // All app threads have marked themselves exited, joining host threads here won't block for long
+        exitedThreadInfo.clear();
+    }
+
+    void WasiPthreadExt::ReapExitedAppThreads(InstancePthreadManager* pManager) {
+        std::vector<std::shared_ptr<InstancePthreadManager::ExecEnvThreadInfo>> exitedThreadInfo;
+        {
             std::lock_guard<std::mutex> _al(pManager->m_threadMapLock);
-            pManager->m_threadMap.erase(pThreadInfo->handleID);
+            for (auto it = pManager->m_threadMap.begin(); it != pManager->m_threadMap.end();) {
+                if (it->second->exitState.load(std::memory_order_acquire) == InstancePthreadManager::ExecEnvThreadInfo::EXIT_STATE_EXITED) {
+                    exitedThreadInfo.push_back(std::move(it->second));
+                    it = pManager->m_threadMap.erase(it);
+                } else {
+                    it++;
+                }
+            }
         }
     }
 
@@ -104,6 +184,7 @@ namespace WAMR_EXT_NS {
                         wasm_runtime_set_exception(get_module_inst(it.second->pExecEnv.get()), exception);
                 }
             }
+            ScheduleInstanceCheck((WamrExtInstance*)wasm_runtime_get_custom_data(get_module_inst(pExecEnv)));
         }
         if (pThreadInfo->handleID == PTHREAD_EXT_MAIN_THREAD_ID)
             return;
@@ -116,11 +197,14 @@ namespace WAMR_EXT_NS {
     int32_t WasiPthreadExt::WasiThreadSpawn(wasm_exec_env_t pExecEnv, uint32_t appArg) {
         wasm_module_inst_t pWasmModuleInst = get_module_inst(pExecEnv);
         auto* pManager = GetInstPthreadManager(pExecEnv);
+        UpdateCPUTimeUsage(pExecEnv);
         wasm_module_inst_t pNewWasmInst = nullptr;
         wasm_exec_env_t pNewWasmExecEnv = nullptr;
         std::shared_ptr<InstancePthreadManager::ExecEnvThreadInfo> pThreadInfo;
         uvwasi_errno_t err = 0;
         int32_t retTid = 0;
+        // Release host threads and wasm instances of exited app threads before spawning a new one
+        ReapExitedAppThreads(pManager);
         do {
             if (!(pNewWasmInst = wasm_runtime_instantiate_internal(wasm_exec_env_get_module(pExecEnv), true, pExecEnv->wasm_stack_size, 0, nullptr, 0))) {
                 err = -1;
@@ -173,6 +257,11 @@ namespace WAMR_EXT_NS {
             }
             {
                 std::lock_guard<std::mutex> _al(pManager->m_threadMapLock);
+                if (pManager->m_bExiting) {
+                    err = UVWASI_EAGAIN;
+                    break;
+                }
+                pManager->m_runningThreadCount++;
                 while (true) {
                     pThreadInfo->handleID = pManager->m_curHandleId++;
                     auto &pTempThreadInfo = pManager->m_threadMap[pThreadInfo->handleID];
@@ -183,8 +272,12 @@ namespace WAMR_EXT_NS {
                     }
                 }
             }
-            pThreadInfo->pHostThread = new std::thread([pCurThreadInfo = pThreadInfo.get(), wasmThreadEntryFuncInst, retTid]{
+            if (err != 0)
+                break;
+            pThreadInfo->pHostThread = new std::thread([pManager, pCurThreadInfo = pThreadInfo.get(), wasmThreadEntryFuncInst, retTid]{
+                EnsureWasmThreadEnv();
                 wasm_exec_env_set_thread_info(pCurThreadInfo->pExecEnv.get());
+                WasiPthreadExt::BeginCPUTimeAccounting(pCurThreadInfo->pExecEnv.get());
                 wasm_val_t argv[2];
                 argv[0].kind = WASM_I32; argv[0].of.i32 = retTid;
                 argv[1].kind = WASM_I32; argv[1].of.i32 = pCurThreadInfo->appStartArg.funcArg;
@@ -194,23 +287,23 @@ namespace WAMR_EXT_NS {
                 // Free app stack
                 if (!pCurThreadInfo->stackCtrl.bStackFromApp)
                     wasm_runtime_module_free(get_module_inst(pCurThreadInfo->pExecEnv.get()), pCurThreadInfo->stackCtrl.appStackAddr);
-                {
-                    std::unique_lock al(pCurThreadInfo->exitCtrl.exitLock);
-                    if (pCurThreadInfo->exitCtrl.waitCount == 0) {
-                        pCurThreadInfo->pHostThread->detach();
-                        pCurThreadInfo->exitCtrl.waitCount = -1;
-                    } else {
-                        pCurThreadInfo->exitCtrl.exitCV.notify_all();
-                    }
-                }
+                WasiPthreadExt::EndCPUTimeAccounting(pCurThreadInfo->pExecEnv.get());
+                pCurThreadInfo->exitState.store(InstancePthreadManager::ExecEnvThreadInfo::EXIT_STATE_EXITED, std::memory_order_release);
+                if (pManager->m_runningThreadCount.fetch_sub(1) == 1)
+                    Utility::FutexWakeAll(pManager->m_runningThreadCount);
             });
         } while (false);
         if (err != 0) {
             if (pThreadInfo) {
                 if (pNewWasmInst && !pThreadInfo->stackCtrl.bStackFromApp && pThreadInfo->stackCtrl.appStackAddr)
                     wasm_runtime_module_free(pNewWasmInst, pThreadInfo->stackCtrl.appStackAddr);
-                std::lock_guard<std::mutex> _al(pManager->m_threadMapLock);
-                pManager->m_threadMap.erase(pThreadInfo->handleID);
+                if (pThreadInfo->handleID != PTHREAD_EXT_MAIN_THREAD_ID) {
+                    std::lock_guard<std::mutex> _al(pManager->m_threadMapLock);
+                    pManager->m_threadMap.erase(pThreadInfo->handleID);
+                }
+                // The new wasm instance and exec env will be released with pThreadInfo
+                pNewWasmInst = nullptr;
+                pNewWasmExecEnv = nullptr;
             }
             if (pNewWasmInst)
                 wasm_runtime_deinstantiate_internal(pNewWasmInst, true);
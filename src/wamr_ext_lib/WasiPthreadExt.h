@@ -1,7 +1,6 @@
 #pragma once
 
 #include "../base/Utility.h"
-#include <condition_variable>
 #include <thread>
 
 namespace WAMR_EXT_NS {
@@ -11,10 +10,28 @@ namespace WAMR_EXT_NS {
         static void Init();
         static void InitAppMainThreadInfo(wasm_exec_env_t pMainExecEnv);
         static void CleanupAppThreadInfo(wasm_exec_env_t pMainExecEnv);
+        // Set exception(if not null) and terminate flag for the main thread and all app threads
+        static void TerminateAppThreads(wasm_exec_env_t pMainExecEnv, const char* exception);
+        // CPU time of the host thread running pExecEnv is sampled from BeginCPUTimeAccounting() to EndCPUTimeAccounting()
+        // and accumulated to the instance by UpdateCPUTimeUsage(), all of them must be called on that host thread
+        static void BeginCPUTimeAccounting(wasm_exec_env_t pExecEnv);
+        static void UpdateCPUTimeUsage(wasm_exec_env_t pExecEnv);
+        static void EndCPUTimeAccounting(wasm_exec_env_t pExecEnv);
+
+        struct InstancePthreadManager;
+        // Call func with the exec env of the main thread and each running app thread while the thread map is locked,
+        // the instance must be kept started by the caller
+        static void ForEachExecEnv(InstancePthreadManager* pManager, const std::function<void(wasm_exec_env_t)>& func);
+        // Accumulate CPU time of host threads running wasm code of the instance from another thread, so that threads
+        // never calling into the host are accounted too. The instance must be kept started by the caller
+        static void SampleCPUTimeUsage(InstancePthreadManager* pManager);
 
         struct InstancePthreadManager {
         public:
             InstancePthreadManager();
+            uint64_t GetCPUTimeUsageNs() const { return m_cpuTimeUsageNs.load(std::memory_order_relaxed); }
+            // App threads excluding the main thread
+            uint32_t GetRunningThreadCount() const { return m_runningThreadCount.load(std::memory_order_relaxed); }
             friend class WasiPthreadExt;
         private:
             struct ExecEnvThreadInfo {
@@ -30,28 +47,49 @@ namespace WAMR_EXT_NS {
                     bool bStackFromApp{false};
                 } stackCtrl;
                 struct {
-                    std::mutex exitLock;
-                    std::condition_variable exitCV;
-                    int32_t waitCount{0};
-                } exitCtrl;
+                    // Taken by both the host thread running the exec env and the sampling thread
+                    std::mutex lock;
+                    bool bAccounting{false};
+#ifndef _WIN32
+                    clockid_t clockID;
+#endif
+                    uint64_t sampleNs{0};
+                } cpuTime;
+                enum : uint32_t {
+                    EXIT_STATE_RUNNING,
+                    EXIT_STATE_EXITED,
+                };
+                std::atomic<uint32_t> exitState{EXIT_STATE_RUNNING};
 
                 explicit ExecEnvThreadInfo(const std::shared_ptr<WASMExecEnv>& env) : pExecEnv(env) {
                     wasm_runtime_set_user_data(pExecEnv.get(), this);
                 }
 
-                ~ExecEnvThreadInfo() { delete pHostThread; }
+                ~ExecEnvThreadInfo() {
+                    if (pHostThread && pHostThread->joinable())
+                        pHostThread->join();
+                    delete pHostThread;
+                }
             };
 
             std::mutex m_threadMapLock;
             std::unordered_map<uint32_t, std::shared_ptr<ExecEnvThreadInfo>> m_threadMap;
             std::atomic<uint32_t> m_curHandleId{1};
+            // Number of app threads that have not exited yet, used as the futex word when joining all threads
+            std::atomic<uint32_t> m_runningThreadCount{0};
+            bool m_bExiting{false};
+            std::atomic<uint64_t> m_cpuTimeUsageNs{0};
 
             std::shared_ptr<ExecEnvThreadInfo> GetThreadInfo(uint32_t handleID);
         };
     private:
         static InstancePthreadManager::ExecEnvThreadInfo* GetExecEnvThreadInfo(wasm_exec_env_t pExecEnv);
         static InstancePthreadManager* GetInstPthreadManager(wasm_exec_env_t pExecEnv);
-        static void DoHostThreadJoin(InstancePthreadManager* pManager, const std::shared_ptr<InstancePthreadManager::ExecEnvThreadInfo>& pThreadInfo);
+        static void DoAllHostThreadsJoin(InstancePthreadManager* pManager);
+        // Must be called with cpuTime.lock of pThreadInfo held
+        static void AccumulateCPUTimeUsage(InstancePthreadManager* pManager, InstancePthreadManager::ExecEnvThreadInfo* pThreadInfo,
+                                           uint64_t curCPUTimeNs);
+        static void ReapExitedAppThreads(InstancePthreadManager* pManager);
         static void CancelAppThread(wasm_exec_env_t pExecEnv) { pExecEnv->suspend_flags.flags |= 0x01; }
         static void DoAppThreadExit(wasm_exec_env_t pExecEnv);
 
@@ -9,6 +9,7 @@
 #include <ifaddrs.h>
 #endif
 #include <net/if.h>
+#include <fcntl.h>
 #ifdef __linux__
 #include <linux/if_packet.h>
 #endif
@@ -300,6 +301,42 @@ namespace WAMR_EXT_NS {
         return err;
     }
 
+    // Wait until a blocking socket becomes readable, so that the wait can be interrupted when the instance is terminated
+    uvwasi_errno_t WasiSocketExt::WaitHostSocketReadable(wasm_exec_env_t pExecEnv, uv_os_sock_t hostSockFD) {
+#ifndef _WIN32
+        int fdFlags = fcntl(hostSockFD, F_GETFL);
+        if (fdFlags == -1 || (fdFlags & O_NONBLOCK))
+            return 0;
+        int pollTimeout = -1;
+        timeval recvTimeout{0, 0};
+        socklen_t optLen = sizeof(recvTimeout);
+        if (getsockopt(hostSockFD, SOL_SOCKET, SO_RCVTIMEO, &recvTimeout, &optLen) == 0 && (recvTimeout.tv_sec > 0 || recvTimeout.tv_usec > 0))
+            pollTimeout = std::min<int64_t>(recvTimeout.tv_sec * 1000 + (recvTimeout.tv_usec + 999) / 1000, INT_MAX);
+        auto* pWamrExtInst = (WamrExtInstance*)wasm_runtime_get_custom_data(get_module_inst(pExecEnv));
+        pollfd pollFDs[2];
+        pollFDs[0].fd = hostSockFD;
+        pollFDs[0].events = POLLIN;
+        pollFDs[1].fd = pWamrExtInst->terminateNotifier.GetPollFD();
+        pollFDs[1].events = POLLIN;
+        while (true) {
+            pollFDs[0].revents = pollFDs[1].revents = 0;
+            int pollret = poll(pollFDs, 2, pollTimeout);
+            if (pollret == -1) {
+                if (errno == EINTR)
+                    continue;
+                return GetSysLastSocketError();
+            } else if (pollret == 0) {
+                return UVWASI_EAGAIN;
+            }
+            if (pollFDs[1].revents)
+                return UVWASI_EINTR;
+            return 0;
+        }
+#else
+#error "Waiting socket is not implemented for Win32"
+#endif
+    }
+
     int32_t WasiSocketExt::SockListen(wasm_exec_env_t pExecEnv, int32_t appSockFD, int32_t backlog) {
         wasm_module_inst_t pWasmModuleInst = get_module_inst(pExecEnv);
         uvwasi_errno_t err;
@@ -321,6 +358,8 @@ namespace WAMR_EXT_NS {
         uvwasi_filetype_t appWasiSockType;
         if ((err = GetHostSocketFD(pWasmModuleInst, appSockFD, hostSockFD, appWasiSockType)) != 0)
             return err;
+        if ((err = WaitHostSocketReadable(pExecEnv, hostSockFD)) != 0)
+            return err;
         sockaddr_storage hostSockAddr;
         socklen_t hostAddrLen = sizeof(hostSockAddr);
         uv_os_sock_t newHostSockFD = accept(hostSockFD, (sockaddr*)&hostSockAddr, &hostAddrLen);
@@ -652,6 +691,8 @@ namespace WAMR_EXT_NS {
         uvwasi_errno_t err;
         if ((err = GetHostSocketFD(pWasmModuleInst, appSockFD, hostSockFD, wasiSockType)) != 0)
             return err;
+        if ((err = WaitHostSocketReadable(pExecEnv, hostSockFD)) != 0)
+            return err;
         sockaddr_storage hostSockAddr;
         hostSockAddr.ss_family = AF_UNSPEC;
 #ifndef _WIN32
@@ -870,7 +911,13 @@ namespace WAMR_EXT_NS {
 #else
 #error "Polling FDs doesn't implement for Win32"
 #endif
-        host_pollfd* pollArr = static_cast<host_pollfd*>(alloca(sizeof(host_pollfd) * appSubCount));
+        // The extra poll FD is used to wake up when the instance is terminated
+        host_pollfd* pollArr = static_cast<host_pollfd*>(alloca(sizeof(host_pollfd) * (appSubCount + 1)));
+        auto* pWamrExtInst = (WamrExtInstance*)wasm_runtime_get_custom_data(pWasmModuleInst);
+        host_pollfd& terminatePollFD = pollArr[appSubCount];
+        terminatePollFD.fd = pWamrExtInst->terminateNotifier.GetPollFD();
+        terminatePollFD.events = POLLIN;
+        terminatePollFD.revents = 0;
         auto* pFDTable = pUVWasi->fds;
         uvwasi_fd_table_lock(pFDTable);
         for (uint32_t i = 0; i < appSubCount; i++) {
@@ -917,8 +964,14 @@ namespace WAMR_EXT_NS {
         if (bSleepOnly) {
             if (!pTimeoutSub)
                 return UVWASI_EINVAL;
-            if (timeoutNanoSec > 0)
-                std::this_thread::sleep_for(std::chrono::nanoseconds(timeoutNanoSec));
+            if (timeoutNanoSec > 0) {
+                uint64_t sleepMs = std::min<uint64_t>(timeoutNanoSec / 1000 / 1000, INT_MAX);
+                if (sleepMs > 0 && poll(&terminatePollFD, 1, sleepMs) > 0)
+                    return UVWASI_EINTR;
+                if (pWamrExtInst->terminateNotifier.IsNotified())
+                    return UVWASI_EINTR;
+                std::this_thread::sleep_for(std::chrono::nanoseconds(timeoutNanoSec - sleepMs * 1000 * 1000));
+            }
             pAppOutEvent[0].error = 0;
             pAppOutEvent[0].userdata = pTimeoutSub->userdata;
             pAppOutEvent[0].type = pTimeoutSub->type;
@@ -928,9 +981,11 @@ namespace WAMR_EXT_NS {
         uint64_t pollTimeout = std::min<uint64_t>(timeoutNanoSec / 1000 / 1000, INT_MAX);
         uvwasi_errno_t err = 0;
 #ifndef _WIN32
-        int hostNEvents = poll(pollArr, appSubCount, pollTimeout);
+        int hostNEvents = poll(pollArr, appSubCount + 1, pollTimeout);
 #else
 #endif
+        if (hostNEvents > 0 && terminatePollFD.revents)
+            return UVWASI_EINTR;
         if (hostNEvents == -1) {
             err = GetSysLastSocketError();
         } else if (hostNEvents == 0) {
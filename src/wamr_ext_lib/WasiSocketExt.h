@@ -29,6 +29,7 @@ namespace WAMR_EXT_NS {
         }
         static uvwasi_errno_t GetHostSocketFD(wasm_module_inst_t pWasmModuleInst, int32_t appSockFD, uv_os_sock_t& outHostSockFD);
         static uvwasi_errno_t GetHostSocketFD(wasm_module_inst_t pWasmModuleInst, int32_t appSockFD, uv_os_sock_t& outHostSockFD, uvwasi_filetype_t& outWasiSockType);
+        static uvwasi_errno_t WaitHostSocketReadable(wasm_exec_env_t pExecEnv, uv_os_sock_t hostSockFD);
         static uvwasi_errno_t InsertNewHostSocketFDToTable(wasm_module_inst_t pWasmModuleInst, uv_os_sock_t hostSockFD, uvwasi_filetype_t wasiSockType, int32_t& outAppSockFD);
 
         static int32_t SockOpen(wasm_exec_env_t pExecEnv, int32_t domain, int32_t type, int32_t protocol, int32_t* outAppSockFD);
@@ -64,6 +64,18 @@ namespace WAMR_EXT_NS {
             *bufLen = sizeof(availMem);
             memcpy(buf, &availMem, *bufLen);
             return 0;
+        } else if (strcmp(name, "stats.syscall") == 0) {
+            // Array of WamrExtSyscallStats, *bufLen is set to the required size if it's too small
+            auto* pWamrExtInst = (WamrExtInstance*)wasm_runtime_get_custom_data(pWasmModule);
+            auto statsList = pWamrExtInst->syscallStats.Collect();
+            uint32_t statsSize = statsList.size() * sizeof(WamrExtSyscallStats);
+            if (*bufLen < statsSize) {
+                *bufLen = statsSize;
+                return UVWASI_ERANGE;
+            }
+            *bufLen = statsSize;
+            memcpy(buf, statsList.data(), statsSize);
+            return 0;
         }
         return UVWASI_EINVAL;
     }
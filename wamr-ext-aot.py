@@ -1,7 +1,12 @@
 #!/usr/bin/env python3
 import argparse
+import hashlib
+import os
+import re
+import struct
 import subprocess
 import sys
+import tempfile
 
 AOT_TARGETS = [
     'arm-gnu',
@@ -11,14 +16,30 @@ AOT_TARGETS = [
     'x86_64-gnu'
 ]
 
-if __name__ == '__main__':
-    arg_parser = argparse.ArgumentParser(description='A tool to compile WASM binary to AOT binary for wamr-ext')
-    arg_parser.add_argument('TARGET', type=str, choices=AOT_TARGETS, help='AOT target')
-    arg_parser.add_argument('INPUT_FILE', type=str, help='Input WASM binary file')
-    arg_parser.add_argument('-o', type=str, help='Output file', required=True)
+# Profile -> (supported targets, CPU, CPU features), SIMD is enabled for all profiles except baseline.
+# Keep consistent with CPUFeatures::IsAOTProfileSupported(), the build fails if a profile is not checked there.
+AOT_PROFILES = {
+    'baseline': (AOT_TARGETS, None, None),
+    'x86-64-v2': (['x86_64-gnu'], 'x86-64-v2', ''),
+    'x86-64-v3': (['x86_64-gnu'], 'x86-64-v3', ''),
+    'x86-64-v4': (['x86_64-gnu'], 'x86-64-v4', ''),
+    'armv8.2-dotprod': (['aarch64-gnu'], 'generic', '+v8.2a,+neon,+dotprod'),
+}
 
-    argv = vars(arg_parser.parse_args())
-    aot_target = argv['TARGET']
+# See the fat AOT file format in wamr_ext_api.cpp
+FAT_AOT_MAGIC = b'\x00wfa'
+FAT_AOT_VERSION = 2
+FAT_AOT_PROFILE_NAME_SIZE = 24
+FAT_AOT_ALIGNMENT = 16
+FAT_AOT_FLAG_HW_BOUND_CHECK = 1
+
+
+def get_runtime_version():
+    with open(os.path.join(os.path.dirname(os.path.abspath(__file__)), 'version.cmake')) as f:
+        return re.search(r'set\(WAMR_EXT_VERSION_STRING\s+(\S+)\)', f.read()).group(1)
+
+
+def compile_aot(argv, aot_target, profile, input_file, output_file, prof_data_file=None):
     aot_arch_target = aot_target.split('-')[0]
     aot_abi = aot_target.split('-')[-1]
     if aot_abi == 'gnueabi':
@@ -30,6 +51,8 @@ if __name__ == '__main__':
         aot_cpu_features = '-neon'
     elif aot_target.startswith('x86_64'):
         aot_cpu = 'core2'
+    if profile != 'baseline':
+        aot_cpu, aot_cpu_features = AOT_PROFILES[profile][1:]
 
     wamrc_args = [
         'wamrc',
@@ -39,13 +62,105 @@ if __name__ == '__main__':
     ]
     if aot_cpu_features:
         wamrc_args += ['--cpu-features=' + aot_cpu_features]
+    if argv['xip']:
+        wamrc_args += ['--xip']
+    if argv['instrument']:
+        wamrc_args += ['--enable-llvm-pgo']
+    if prof_data_file:
+        wamrc_args += ['--use-prof-file=' + prof_data_file]
 
     wamrc_args += [
-        '--bounds-checks=1',
+        '--bounds-checks=0' if argv['hw_bound_check'] else '--bounds-checks=1',
         '--disable-aux-stack-check',
-        '--disable-simd',
-        '-o', argv['o'],
-        argv['INPUT_FILE']
     ]
+    if profile == 'baseline':
+        wamrc_args += ['--disable-simd']
+    wamrc_args += [
+        '-o', output_file,
+        input_file
+    ]
+    return subprocess.run(wamrc_args).returncode
+
+
+def write_fat_aot(output_file, profile_files, flags):
+    header_size = 16 + len(profile_files) * (FAT_AOT_PROFILE_NAME_SIZE + 8)
+    entries = b''
+    blobs = b''
+    offset = header_size
+    for profile, aot_file in profile_files:
+        with open(aot_file, 'rb') as f:
+            data = f.read()
+        padding = (-offset) % FAT_AOT_ALIGNMENT
+        blobs += b'\x00' * padding
+        offset += padding
+        entries += struct.pack('<%dsII' % FAT_AOT_PROFILE_NAME_SIZE, profile.encode(), offset, len(data))
+        blobs += data
+        offset += len(data)
+    with open(output_file, 'wb') as f:
+        f.write(FAT_AOT_MAGIC + struct.pack('<III', FAT_AOT_VERSION, len(profile_files), flags) + entries + blobs)
+
+
+if __name__ == '__main__':
+    arg_parser = argparse.ArgumentParser(description='A tool to compile WASM binary to AOT binary for wamr-ext')
+    arg_parser.add_argument('TARGET', type=str, choices=AOT_TARGETS, help='AOT target')
+    arg_parser.add_argument('INPUT_FILE', type=str, help='Input WASM binary file')
+    output_group = arg_parser.add_mutually_exclusive_group(required=True)
+    output_group.add_argument('-o', type=str, help='Output file')
+    output_group.add_argument('--cache-dir', type=str,
+                              help='Output to the AOT cache dir(WAMR_EXT_GLOBAL_OPT_AOT_CACHE_DIR) with the name looked up by wamr-ext')
+    arg_parser.add_argument('--runtime-version', type=str, help='wamr-ext version used in the AOT cache file name, defaults to the version of this source tree')
+    arg_parser.add_argument('--profile', type=str, choices=AOT_PROFILES.keys(), action='append',
+                            help='CPU profile, SIMD is enabled except for baseline. It can be specified multiple times from the best '
+                                 'to generate a fat AOT file, wamr-ext loads the first profile supported by the host CPU. '
+                                 'Add baseline at last as the fallback. Defaults to baseline')
+    arg_parser.add_argument('--hw-bound-check', action='store_true',
+                            help='Omit bounds checks for wamr-ext built with WAMR_EXT_HW_BOUND_CHECK(64-bit targets only). The output is always '
+                                 'a fat AOT file recording the bound check mode, wamr-ext refuses to load AOT files of the other mode')
+    arg_parser.add_argument('--xip', action='store_true',
+                            help='Generate code without relocations, which is executed from a read-only shared mapping of the file when loaded with WAMR_EXT_MODULE_LOAD_FLAG_XIP')
+    pgo_group = arg_parser.add_mutually_exclusive_group()
+    pgo_group.add_argument('--instrument', action='store_true',
+                           help='Generate instrumented code collecting PGO profile data, which is dumped by '
+                                'wamr_ext_instance_dump_pgo_profile() or wamr_ext_miniapp --pgo-profile')
+    pgo_group.add_argument('--use-profile', type=str, action='append',
+                           help='Optimize with PGO profile data(.profraw dumped by wamr-ext or .profdata merged by llvm-profdata), '
+                                'it can be specified multiple times to merge profiles of multiple runs')
+
+    argv = vars(arg_parser.parse_args())
+    aot_target = argv['TARGET']
+    if argv['hw_bound_check'] and aot_target not in ('x86_64-gnu', 'aarch64-gnu'):
+        arg_parser.error('--hw-bound-check is only supported by 64-bit targets')
+    profiles = argv['profile'] or ['baseline']
+    for profile in profiles:
+        if aot_target not in AOT_PROFILES[profile][0]:
+            arg_parser.error('Profile %s is not supported by target %s' % (profile, aot_target))
+    output_file = argv['o']
+    if argv['cache_dir']:
+        with open(argv['INPUT_FILE'], 'rb') as f:
+            content_digest = hashlib.sha256(f.read()).hexdigest()
+        runtime_version = argv['runtime_version'] or get_runtime_version()
+        os.makedirs(argv['cache_dir'], exist_ok=True)
+        variant_suffix = '-hwbc' if argv['hw_bound_check'] else ''
+        output_file = os.path.join(argv['cache_dir'], '%s-%s%s-%s.aot' % (content_digest, aot_target, variant_suffix, runtime_version))
 
-    sys.exit(subprocess.run(wamrc_args).returncode)
+    with tempfile.TemporaryDirectory() as temp_dir:
+        prof_data_file = None
+        if argv['use_profile']:
+            # Raw profiles must be merged into the indexed format accepted by wamrc
+            prof_data_file = os.path.join(temp_dir, 'merged.profdata')
+            ret = subprocess.run(['llvm-profdata', 'merge', '-o', prof_data_file] + argv['use_profile']).returncode
+            if ret != 0:
+                sys.exit(ret)
+        if profiles == ['baseline'] and not argv['hw_bound_check']:
+            sys.exit(compile_aot(argv, aot_target, 'baseline', argv['INPUT_FILE'], output_file, prof_data_file))
+        # Wrap AOT files of SIMD profiles or without bounds checks in a fat AOT file even if there is only one profile,
+        # so that wamr-ext can refuse to load them on hosts without the required CPU features or by a runtime built
+        # with a different bound check mode
+        profile_files = []
+        for profile in profiles:
+            profile_file = os.path.join(temp_dir, profile + '.aot')
+            ret = compile_aot(argv, aot_target, profile, argv['INPUT_FILE'], profile_file, prof_data_file)
+            if ret != 0:
+                sys.exit(ret)
+            profile_files.append((profile, profile_file))
+        write_fat_aot(output_file, profile_files, FAT_AOT_FLAG_HW_BOUND_CHECK if argv['hw_bound_check'] else 0)
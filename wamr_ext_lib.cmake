@@ -19,17 +19,58 @@ if (WAMR_BUILD_TARGET MATCHES "ARM")
     # Forced to be armv7 for AOT
     set(WAMR_BUILD_TARGET ARMV7)
 endif()
+# AOT target of wamr-ext-aot.py, which is a part of names of files in the AOT cache dir
+if (NOT WAMR_EXT_AOT_TARGET)
+    if (WAMR_BUILD_TARGET STREQUAL "X86_64")
+        set(WAMR_EXT_AOT_TARGET x86_64-gnu)
+    elseif (WAMR_BUILD_TARGET STREQUAL "AARCH64")
+        set(WAMR_EXT_AOT_TARGET aarch64-gnu)
+    elseif (WAMR_BUILD_TARGET STREQUAL "ARMV7")
+        if (ARM_ABI_HARD)
+            set(WAMR_EXT_AOT_TARGET arm-gnueabihf)
+        else()
+            set(WAMR_EXT_AOT_TARGET arm-gnueabi)
+        endif()
+    else()
+        set(WAMR_EXT_AOT_TARGET unknown)
+    endif()
+endif()
+# Run bytecode by fast JIT first and switch hot functions to LLVM JIT compiled in background, it requires LLVM libraries
+option(WAMR_EXT_BUILD_MULTI_TIER_JIT "Build WAMR with multi-tier JIT instead of fast interpreter" OFF)
 set(WAMR_BUILD_INTERP 1)
-set(WAMR_BUILD_FAST_INTERP 1)
+if (WAMR_EXT_BUILD_MULTI_TIER_JIT)
+    set(WAMR_BUILD_FAST_INTERP 0)
+    set(WAMR_BUILD_FAST_JIT 1)
+    set(WAMR_BUILD_JIT 1)
+    set(WAMR_BUILD_LAZY_JIT 1)
+else()
+    set(WAMR_BUILD_FAST_INTERP 1)
+endif()
 set(WAMR_BUILD_AOT 1)
-set(WAMR_DISABLE_HW_BOUND_CHECK 1)      # Don't mmap large memory
+# Reserve 8GB address space with guard pages for each linear memory and trap out of bounds accesses by signals,
+# AOT files must be compiled by wamr-ext-aot.py --hw-bound-check then
+option(WAMR_EXT_HW_BOUND_CHECK "Use hardware bound check on 64-bit Linux instead of software bound check" OFF)
+if (WAMR_EXT_HW_BOUND_CHECK AND WAMR_BUILD_PLATFORM STREQUAL "linux" AND (WAMR_BUILD_TARGET STREQUAL "X86_64" OR WAMR_BUILD_TARGET STREQUAL "AARCH64"))
+    set(WAMR_DISABLE_HW_BOUND_CHECK 0)
+else()
+    set(WAMR_DISABLE_HW_BOUND_CHECK 1)      # Don't mmap large memory
+endif()
 set(WAMR_BUILD_LIBC_BUILTIN 1)
 set(WAMR_BUILD_LIBC_UVWASI 1)
 set(WAMR_BUILD_BULK_MEMORY 1)
+if (WAMR_BUILD_TARGET STREQUAL "X86_64" OR WAMR_BUILD_TARGET STREQUAL "AARCH64")
+    # Required by AOT files compiled with SIMD profiles of wamr-ext-aot.py
+    set(WAMR_BUILD_SIMD 1)
+endif()
 set(WAMR_BUILD_SHARED_MEMORY 1)
 set(WAMR_BUILD_THREAD_MGR 1)
 set(WAMR_BUILD_LIB_PTHREAD 0)
 set(WAMR_BUILD_DUMP_CALL_STACK 1)
+# Collect profile data from AOT code compiled by wamr-ext-aot.py --instrument
+option(WAMR_EXT_BUILD_STATIC_PGO "Build WAMR with static PGO support" OFF)
+if (WAMR_EXT_BUILD_STATIC_PGO)
+    set(WAMR_BUILD_STATIC_PGO 1)
+endif()
 set(WAMR_BUILD_CUSTOM_NAME_SECTION 1)
 set(WAMR_BUILD_MULTI_MODULE 0)
 include(${WAMR_ROOT_DIR}/build-scripts/runtime_lib.cmake)
@@ -59,6 +100,14 @@ add_library(wamr_ext_obj OBJECT
         ${WAMR_EXT_ROOT_DIR}/src/base/Utility.cpp
         ${WAMR_EXT_ROOT_DIR}/src/base/FSUtility.cpp
         ${WAMR_EXT_ROOT_DIR}/src/base/LoopThread.cpp
+        ${WAMR_EXT_ROOT_DIR}/src/base/TimerWheel.cpp
+        ${WAMR_EXT_ROOT_DIR}/src/base/WorkerThreadPool.cpp
+        ${WAMR_EXT_ROOT_DIR}/src/base/RingBufferAllocator.cpp
+        ${WAMR_EXT_ROOT_DIR}/src/base/EventNotifier.cpp
+        ${WAMR_EXT_ROOT_DIR}/src/base/CPUFeatures.cpp
+        ${WAMR_EXT_ROOT_DIR}/src/base/CPUFeaturesBuildTarget.cpp
+        ${WAMR_EXT_ROOT_DIR}/src/base/PerfMap.cpp
+        ${WAMR_EXT_ROOT_DIR}/src/base/SHA256.cpp
         ${WAMR_EXT_ROOT_DIR}/src/wamr_ext_lib/WamrExtInternalDef.cpp
         ${WAMR_EXT_ROOT_DIR}/src/wamr_ext_lib/WasiPthreadExt.cpp
         ${WAMR_EXT_ROOT_DIR}/src/wamr_ext_lib/WasiWamrExt.cpp
@@ -66,8 +115,34 @@ add_library(wamr_ext_obj OBJECT
         ${WAMR_EXT_ROOT_DIR}/src/wamr_ext_lib/WasiSocketExt.cpp
         ${WAMR_EXT_ROOT_DIR}/src/wamr_ext_lib/WasiProcessExt.cpp
         ${WAMR_EXT_ROOT_DIR}/src/wamr_ext_lib/WasiMiscExt.cpp
+        ${WAMR_EXT_ROOT_DIR}/src/wamr_ext_lib/WasiChannelExt.cpp
+        ${WAMR_EXT_ROOT_DIR}/src/wamr_ext_lib/ExtSyscallStats.cpp
+        ${WAMR_EXT_ROOT_DIR}/src/wamr_ext_lib/WamrExtProfiler.cpp
         )
 target_include_directories(wamr_ext_obj PRIVATE ${WAMR_EXT_INCLUDE_DIRS})
+# Every CPU profile of wamr-ext-aot.py must be checked by CPUFeatures::IsAOTProfileSupported(), otherwise fat AOT files
+# never load the profile
+file(READ ${WAMR_EXT_ROOT_DIR}/wamr-ext-aot.py WAMR_EXT_AOT_SCRIPT)
+file(READ ${WAMR_EXT_ROOT_DIR}/src/base/CPUFeatures.cpp WAMR_EXT_CPU_FEATURES_SOURCE)
+string(REGEX MATCH "AOT_PROFILES = {[^}]*}" WAMR_EXT_AOT_PROFILES "${WAMR_EXT_AOT_SCRIPT}")
+string(REGEX MATCHALL "'[^']+': \\(" WAMR_EXT_AOT_PROFILES "${WAMR_EXT_AOT_PROFILES}")
+foreach (PROFILE_ENTRY ${WAMR_EXT_AOT_PROFILES})
+    string(REGEX REPLACE "'([^']+)'.*" "\\1" PROFILE_NAME "${PROFILE_ENTRY}")
+    string(FIND "${WAMR_EXT_CPU_FEATURES_SOURCE}" "\"${PROFILE_NAME}\"" PROFILE_POS)
+    if (PROFILE_POS EQUAL -1)
+        message(FATAL_ERROR "AOT profile ${PROFILE_NAME} of wamr-ext-aot.py is not checked by src/base/CPUFeatures.cpp")
+    endif()
+endforeach()
+# Check SHA256 against the FIPS 180-2 test vectors while building, its digests decide module sharing and AOT cache file names
+if (NOT CMAKE_CROSSCOMPILING)
+    add_executable(wamr_ext_sha256_check
+            ${WAMR_EXT_ROOT_DIR}/src/base/SHA256Check.cpp
+            ${WAMR_EXT_ROOT_DIR}/src/base/SHA256.cpp
+            )
+    target_include_directories(wamr_ext_sha256_check PRIVATE ${WAMR_EXT_INCLUDE_DIRS})
+    add_custom_command(TARGET wamr_ext_sha256_check POST_BUILD COMMAND wamr_ext_sha256_check VERBATIM)
+    add_dependencies(wamr_ext_obj wamr_ext_sha256_check)
+endif()
 
 set(WAMR_EXT_DEP_LIBS wamr)
 if (ANDROID)
@@ -78,5 +153,8 @@ add_library(wamr_ext_static STATIC
         ${WAMR_EXT_ROOT_DIR}/src/wamr_ext_api/wamr_ext_api.cpp
         )
 target_include_directories(wamr_ext_static PRIVATE include ${WAMR_EXT_INCLUDE_DIRS})
-target_compile_definitions(wamr_ext_static PRIVATE -DWAMR_EXT_STATIC_LIB)
+target_compile_definitions(wamr_ext_static PRIVATE -DWAMR_EXT_STATIC_LIB -DWAMR_EXT_AOT_TARGET="${WAMR_EXT_AOT_TARGET}")
+if (WAMR_EXT_BUILD_MULTI_TIER_JIT)
+    target_compile_definitions(wamr_ext_static PRIVATE -DWAMR_EXT_MULTI_TIER_JIT)
+endif()
 target_link_libraries(wamr_ext_static PRIVATE ${WAMR_EXT_DEP_LIBS})